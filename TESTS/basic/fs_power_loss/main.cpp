@@ -0,0 +1,301 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "HeapBlockDevice.h"
+#include "FaultBlockDevice.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// The power loss is simulated on a heap block device whatever the test block device is
+#ifndef POWER_LOSS_BLOCK_SIZE
+#define POWER_LOSS_BLOCK_SIZE 512
+#endif
+#ifndef POWER_LOSS_BLOCK_COUNT
+#define POWER_LOSS_BLOCK_COUNT 256
+#endif
+
+static const size_t path_size = 32;
+static const size_t max_file_size = 64;
+
+HeapBlockDevice heap_bd(POWER_LOSS_BLOCK_COUNT * POWER_LOSS_BLOCK_SIZE, POWER_LOSS_BLOCK_SIZE);
+FaultBlockDevice fault_bd(&heap_bd);
+
+FILE *fd;
+
+static char file_path[path_size];
+
+/* A workload builds its starting state with setup(), then power is cut while
+ * run() executes. After the remount the file must hold either the old or the
+ * new data, a NULL data means the file does not exist.
+ */
+struct workload_t {
+    void (*setup)();
+    void (*run)();
+    const char *old_data;
+    const char *new_data;
+};
+
+// Outcomes of a power cut, as found after the remount
+enum outcome_t {
+    OUTCOME_OLD,
+    OUTCOME_NEW,
+    OUTCOME_CORRUPT,
+    OUTCOME_MOUNT_FAILED,
+    OUTCOMES
+};
+
+static const char *const outcome_names[OUTCOMES] = {
+    "old data", "new data", "corrupt", "mount failed"
+};
+
+static const char *const outcome_metrics[OUTCOMES] = {
+    "old_data_cuts", "new_data_cuts", "corrupt_cuts", "mount_failed_cuts"
+};
+
+/*----------------workloads------------------*/
+
+static void write_file(const char *data)
+{
+    int res = !((fd = fopen(file_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    int write_sz = fwrite(data, sizeof(char), strlen(data), fd);
+    TEST_ASSERT_EQUAL(strlen(data), write_sz);
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/* The run() functions ignore errors, every call after the power cut is
+ * expected to fail
+ */
+
+static void setup_none()
+{
+}
+
+static void setup_append()
+{
+    write_file("1234567890123456");
+}
+
+//append buffer to non empty file, as in FS_append_non_empty_file
+static void run_append()
+{
+    if ((fd = fopen(file_path, "a+")) != NULL) {
+        fwrite("abcdefghijklmnop", sizeof(char), 16, fd);
+        fclose(fd);
+    }
+}
+
+static void setup_rewrite()
+{
+    write_file("12345678901234");
+}
+
+//rewrite file middle, as in FS_fseek_rewrite_non_empty_file_middle
+static void run_rewrite()
+{
+    if ((fd = fopen(file_path, "r+")) != NULL) {
+        fseek(fd, 5, SEEK_SET);
+        fwrite("abcde", sizeof(char), 5, fd);
+        fclose(fd);
+    }
+}
+
+//create a new file, as in FS_fopen_write_fifteen_byte_file
+static void run_create()
+{
+    if ((fd = fopen(file_path, "w")) != NULL) {
+        fwrite("12345678901234", sizeof(char), 14, fd);
+        fclose(fd);
+    }
+}
+
+enum workload_id_t {
+    WORKLOAD_APPEND,
+    WORKLOAD_REWRITE,
+    WORKLOAD_CREATE
+};
+
+static const workload_t workloads[] = {
+    {setup_append, run_append, "1234567890123456", "1234567890123456abcdefghijklmnop"},
+    {setup_rewrite, run_rewrite, "12345678901234", "12345abcde1234"},
+    {setup_none, run_create, NULL, "12345678901234"},
+};
+
+/*----------------help functions------------------*/
+
+static bool file_matches(const char *data)
+{
+    char read_buf[max_file_size + 1] = {};
+
+    FILE *file = fopen(file_path, "r");
+    if (!file) {
+        return data == NULL;
+    }
+
+    size_t read_sz = fread(read_buf, sizeof(char), max_file_size, file);
+    fclose(file);
+
+    // A file left empty by an interrupted create counts as not existing
+    if (!data) {
+        return read_sz == 0;
+    }
+    return read_sz == strlen(data) && memcmp(read_buf, data, read_sz) == 0;
+}
+
+// Format the heap device and build the starting state of the workload
+static void prepare(const workload_t &workload)
+{
+    fault_bd.clear_fault();
+
+    int res = test_fs_format(&fault_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&fault_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    workload.setup();
+
+    res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&fault_bd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------power loss------------------*/
+
+/* Cut the power after every program or erase the workload does, remount and
+ * check that the file holds the old or the new data. LittleFS must always
+ * recover one of them, FAT gives no such guarantee so its outcomes are only
+ * reported.
+ */
+template <test_fs_t type, workload_id_t id>
+void FS_power_loss()
+{
+    const workload_t &workload = workloads[id];
+    LatencyHistogram mount_time;
+    size_t outcomes[OUTCOMES] = {};
+
+    test_fs_select(type);
+    snprintf(file_path, sizeof(file_path), "/%s/hello", test_fs_name());
+
+    // Count the writes of a run without power loss
+    prepare(workload);
+    fault_bd.clear_fault();
+    workload.run();
+    bd_size_t total_ops = fault_bd.get_write_count();
+
+    int res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (bd_size_t cut = 0; cut <= total_ops; cut++) {
+        prepare(workload);
+
+        fault_bd.set_fault_after(cut);
+        workload.run();
+
+        // Drop the file system state, every write it attempts now fails
+        fs->unmount();
+        fault_bd.clear_fault();
+
+        Timer timer;
+        timer.start();
+        res = fs->mount(&fault_bd);
+        timer.stop();
+
+        if (res) {
+            outcomes[OUTCOME_MOUNT_FAILED]++;
+            continue;
+        }
+        mount_time.record(timer.read_us());
+
+        if (file_matches(workload.new_data)) {
+            outcomes[OUTCOME_NEW]++;
+        } else if (file_matches(workload.old_data)) {
+            outcomes[OUTCOME_OLD]++;
+        } else {
+            outcomes[OUTCOME_CORRUPT]++;
+        }
+
+        res = fs->unmount();
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    printf("%llu cut points\n", (unsigned long long)total_ops + 1);
+    for (int i = 0; i < OUTCOMES; i++) {
+        printf("%-14s %8lu\n", outcome_names[i], (unsigned long)outcomes[i]);
+        perf_report(outcomes[i], "%s", outcome_metrics[i]);
+    }
+    printf("mount after power loss (us): p50 %lu, p99 %lu, max %lu\n",
+           (unsigned long)mount_time.percentile(50),
+           (unsigned long)mount_time.percentile(99),
+           (unsigned long)mount_time.max());
+    perf_report(mount_time.percentile(50), "mount_p50_us");
+    perf_report(mount_time.percentile(99), "mount_p99_us");
+    perf_report(mount_time.max(), "mount_max_us");
+
+    if (type == TEST_FS_LFS) {
+        TEST_ASSERT_EQUAL(0, outcomes[OUTCOME_MOUNT_FAILED]);
+        TEST_ASSERT_EQUAL(0, outcomes[OUTCOME_CORRUPT]);
+    }
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FAT_power_loss_append_non_empty_file", FS_power_loss<TEST_FS_FAT, WORKLOAD_APPEND>),
+    Case("FAT_power_loss_rewrite_non_empty_file_middle", FS_power_loss<TEST_FS_FAT, WORKLOAD_REWRITE>),
+    Case("FAT_power_loss_create_file", FS_power_loss<TEST_FS_FAT, WORKLOAD_CREATE>),
+
+    Case("LFS_power_loss_append_non_empty_file", FS_power_loss<TEST_FS_LFS, WORKLOAD_APPEND>),
+    Case("LFS_power_loss_rewrite_non_empty_file_middle", FS_power_loss<TEST_FS_LFS, WORKLOAD_REWRITE>),
+    Case("LFS_power_loss_create_file", FS_power_loss<TEST_FS_LFS, WORKLOAD_CREATE>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(600, "default_auto");
+
+    int res = fault_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fault_bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
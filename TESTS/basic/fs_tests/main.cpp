@@ -16,23 +16,20 @@
 #include "greentea-client/test_env.h"
 #include "unity/unity.h"
 #include "utest/utest.h"
-#include "LittleFileSystem.h"
-#include "FATFileSystem.h"
-#include "HeapBlockDevice.h"
-
-#ifndef TEST_SD 
-#define TEST_SPIF
-#endif
-
-#if !defined(TEST_SPIF) && !defined(TEST_SD)
-#error [NOT_SUPPORTED] storage test not supported on this platform
-#endif
-
-#ifdef TEST_SPIF
-#include "SPIFBlockDevice.h"
-#elif defined TEST_SD
-#include "SDBlockDevice.h"
-#endif
+#include "test_storage.h"
+#include "posix_timing.h"
+#include "CountingBlockDevice.h"
+#include "perf_report.h"
+#include "memory_stats.h"
+#include "PatternGenerator.h"
+
+// Route the calls under test through the timing layer
+#define fopen   buffered_fopen
+#define fwrite  timed_fwrite
+#define fread   timed_fread
+#define fseek   timed_fseek
+#define fflush  timed_fflush
+#define fclose  timed_fclose
 
 using namespace utest::v1;
 
@@ -40,170 +37,343 @@ static const size_t small_buf_size    = 10;
 static const size_t medium_buf_size   = 250;
 static const size_t large_buf_size    = 1200;
 static const size_t test_files        = 4;
+static const size_t path_size         = 64;
 
-FILE *fd[test_files];
+/* With -DTEST_SHARED_MOUNT the volume is formatted and mounted once before
+ * the first case and every case works in a directory of its own, otherwise
+ * every case formats and mounts a fresh volume. With -DTEST_REFORMAT_EVERY=N
+ * the shared volume is formatted again every N cases.
+ */
+#ifndef TEST_REFORMAT_EVERY
+#define TEST_REFORMAT_EVERY 0
+#endif
+
+/* With -DTEST_STDIO_BUFFERING=_IONBF, _IOLBF or _IOFBF every stream the cases
+ * open is switched to that buffering mode with setvbuf, with a buffer of
+ * -DTEST_STDIO_BUFFER_SIZE bytes, otherwise the newlib defaults are used.
+ */
+#ifndef TEST_STDIO_BUFFER_SIZE
+#define TEST_STDIO_BUFFER_SIZE BUFSIZ
+#endif
+
+/* Every case fails when it leaves memory allocated. With -DTEST_HEAP_BUDGET=N
+ * and -DTEST_STACK_BUDGET=N the run also fails when the heap or the stack
+ * peak since boot goes above N bytes.
+ */
+#ifndef TEST_HEAP_BUDGET
+#define TEST_HEAP_BUDGET 0
+#endif
+#ifndef TEST_STACK_BUDGET
+#define TEST_STACK_BUDGET 0
+#endif
 
-#ifdef TEST_SPIF
-SPIFBlockDevice bd(
-    MBED_CONF_SPIF_DRIVER_SPI_MOSI, 
-    MBED_CONF_SPIF_DRIVER_SPI_MISO,  
-    MBED_CONF_SPIF_DRIVER_SPI_CLK, 
-    MBED_CONF_SPIF_DRIVER_SPI_CS
-    );
-#elif defined TEST_SD
-SDBlockDevice bd(
-    MBED_CONF_SD_SPI_MOSI, 
-    MBED_CONF_SD_SPI_MISO, 
-    MBED_CONF_SD_SPI_CLK, 
-    MBED_CONF_SD_SPI_CS
-    );
-#elif defined TEST_HEAP
-#define BLOCK_SIZE 512
-#define BLOCK_COUNT 512
-HeapBlockDevice bd(
-    BLOCK_COUNT*BLOCK_SIZE, 
-    BLOCK_SIZE
-    );
+/* With -DTEST_SHARDS=N the cases are split into N shards of consecutive
+ * cases and the build runs only shard -DTEST_SHARD (0 to N - 1), the cases
+ * of the other shards are reported as ignored. The shards can run on N
+ * boards at once.
+ */
+#ifndef TEST_SHARDS
+#define TEST_SHARDS 1
+#endif
+#ifndef TEST_SHARD
+#define TEST_SHARD 0
 #endif
 
-#define TEST_FAT
-#ifdef TEST_LFS
-LittleFileSystem *fs = new LittleFileSystem("lfs");
-#elif defined TEST_FAT
-FATFileSystem *fs = new FATFileSystem("lfs");
+#if TEST_SHARD >= TEST_SHARDS
+#error TEST_SHARD must be below TEST_SHARDS
 #endif
 
+FILE *fd[test_files];
+
+// Counts the block device traffic of each test case
+CountingBlockDevice counting_bd(&bd);
+
+// Directory the current case creates its files in
+static char case_dir[path_size] = "";
+static size_t case_count = 0;
+
+/*----------------case tables------------------*/
+
+/* The cases of a family that differ only in their parameters are expanded
+ * from the tables below into FS_TEST_CASES, every row of a table gives one
+ * case per row of the tables it is crossed with. Each table takes the macro
+ * to expand a row with, X, and passes CASE through to it.
+ */
+
+// fopen modes: name in the case name, mode, and whether it creates a missing file
+#define FOPEN_MODES(X, CASE) \
+    X(CASE, wb,         "wb",   true) \
+    X(CASE, a,          "a",    true) \
+    X(CASE, r,          "r",    false) \
+    X(CASE, a_update,   "a+",   true) \
+    X(CASE, r_update,   "r+",   false) \
+    X(CASE, w_update,   "w+",   true) \
+    X(CASE, w,          "w",    true) \
+    X(CASE, ab,         "ab",   true) \
+    X(CASE, rb,         "rb",   false) \
+    X(CASE, wb_update,  "wb+",  true) \
+    X(CASE, ab_update,  "ab+",  true) \
+    X(CASE, rb_update,  "rb+",  false)
+
+// Modes files are created with: name in the case name and mode
+#define WRITE_MODES(X, CASE) \
+    X(CASE, write,          "w") \
+    X(CASE, write_update,   "w+") \
+    X(CASE, append,         "a") \
+    X(CASE, append_update,  "a+")
+
+// Sizes of the created files: name in the case name and size in bytes
+#define WRITE_SIZES(X, CASE, mode) \
+    X(CASE, mode, one_byte,       1) \
+    X(CASE, mode, two_byte,       2) \
+    X(CASE, mode, five_byte,      5) \
+    X(CASE, mode, fifteen_byte,   15) \
+    X(CASE, mode, five_Kbyte,     5000) \
+    X(CASE, mode, 64_Kbyte,       64 * 1024) \
+    X(CASE, mode, one_Mbyte,      1024 * 1024)
+
+// fseek origins: name in the case name and whence
+#define SEEK_WHENCES(X, CASE) \
+    X(CASE, set,    SEEK_SET) \
+    X(CASE, cur,    SEEK_CUR) \
+    X(CASE, end,    SEEK_END)
+
+#define FOPEN_MODE_ID(CASE, name, mode, creates) FOPEN_MODE_ ## name,
+#define FOPEN_MODE_ENTRY(CASE, name, mode, creates) {mode, creates},
+#define FOPEN_MODE_CASE(CASE, name, mode, creates) \
+    CASE("FS_fopen_supported_" #name "_mode", FS_fopen_supported_mode<FOPEN_MODE_ ## name>)
+
+#define WRITE_MODE_ID(CASE, name, mode) WRITE_MODE_ ## name,
+#define WRITE_MODE_ENTRY(CASE, name, mode) mode,
+#define WRITE_MODE_CASES(CASE, name, mode) WRITE_SIZES(WRITE_SIZE_CASE, CASE, name)
+#define WRITE_SIZE_CASE(CASE, mode, name, size) \
+    CASE("FS_fopen_" #mode "_" #name "_file", (FS_fopen_write_file<WRITE_MODE_ ## mode, size>))
+
+#define SEEK_WHENCE_CASES(CASE, name, whence) \
+    CASE("FS_fseek_empty_file_seek_" #name, (FS_fseek<whence, SEEK_OFFSET_ZERO, false>)) \
+    CASE("FS_fseek_non_empty_file_seek_" #name, (FS_fseek<whence, SEEK_OFFSET_ZERO, true>)) \
+    CASE("FS_fseek_beyond_empty_file_seek_" #name, (FS_fseek<whence, SEEK_OFFSET_BEYOND, false>)) \
+    CASE("FS_fseek_beyond_non_empty_file_seek_" #name, (FS_fseek<whence, SEEK_OFFSET_BEYOND, true>))
+
+struct fopen_mode_t {
+    const char *mode;
+    bool creates;
+};
+
+enum fopen_mode_id_t {
+    FOPEN_MODES(FOPEN_MODE_ID, _)
+};
+
+static const fopen_mode_t fopen_modes[] = {
+    FOPEN_MODES(FOPEN_MODE_ENTRY, _)
+};
+
+enum write_mode_id_t {
+    WRITE_MODES(WRITE_MODE_ID, _)
+};
+
+static const char *const write_modes[] = {
+    WRITE_MODES(WRITE_MODE_ENTRY, _)
+};
+
+// Offsets fseek is called with, relative to whence
+enum seek_offset_t {
+    SEEK_OFFSET_ZERO,
+    SEEK_OFFSET_BEYOND,     // beyond the end of the file
+    SEEK_OFFSET_NEGATIVE    // back to the beginning of the file
+};
+
+// Chunk the large files are written and read in
+static uint8_t chunk_buf[512];
+
 /*----------------help functions------------------*/
 
-static void init()
+// Full path of a file in the directory of the current case
+static const char *test_path(const char *name)
 {
-    int res = bd.init();
-    TEST_ASSERT_EQUAL(0, res);
+    static char paths[test_files][path_size];
+    static size_t next = 0;
 
-    res = fs->format(&bd);
-    TEST_ASSERT_EQUAL(0, res);
+    char *path = paths[next++ % test_files];
+    snprintf(path, path_size, "%s/%s", case_dir, name);
+    return path;
+}
 
-    res = fs->mount(&bd);
-    TEST_ASSERT_EQUAL(0, res);
+// fopen with the buffering selected at compile time
+static FILE *buffered_fopen(const char *path, const char *mode)
+{
+    FILE *file = timed_fopen(path, mode);
+
+#ifdef TEST_STDIO_BUFFERING
+    if (file) {
+        int res = setvbuf(file, NULL, TEST_STDIO_BUFFERING, TEST_STDIO_BUFFER_SIZE);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+#endif
+
+    return file;
 }
 
-static void deinit()
+static void format_and_mount()
 {
-    int res = bd.deinit();
+    int res = test_fs_format(&counting_bd);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fs->unmount();
+    res = fs->mount(&counting_bd);
     TEST_ASSERT_EQUAL(0, res);
 }
 
-/*----------------fopen()------------------*/
-
-//fopen path without fs prefix
-static void FS_fopen_path_not_valid()
+static void print_bd_traffic()
 {
-    init();
-
-    int res = !((fd[0] = fopen("hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(1, res);
+    printf("%-14s %8s %8s\n", "bd", "count", "bytes");
+    printf("%-14s %8llu %8llu\n", "read", (unsigned long long)counting_bd.get_read_count(), (unsigned long long)counting_bd.get_read_bytes());
+    printf("%-14s %8llu %8llu\n", "program", (unsigned long long)counting_bd.get_program_count(), (unsigned long long)counting_bd.get_program_bytes());
+    printf("%-14s %8llu %8llu\n", "erase", (unsigned long long)counting_bd.get_erase_count(), (unsigned long long)counting_bd.get_erase_bytes());
+    printf("%-14s %8llu %8s\n", "sync", (unsigned long long)counting_bd.get_sync_count(), "-");
 
-    deinit();
+    // Bytes programmed on the device for each byte passed to fwrite
+    uint64_t written = posix_timing_case_bytes(TIMING_FWRITE);
+    if (written) {
+        printf("write amplification %.1f\n", (double)counting_bd.get_program_bytes() / (double)written);
+    }
 }
 
-//fopen empty file name with r mode
-static void FS_fopen_empty_path_r_mode()
+static void init()
 {
-    init();
+    posix_timing_case_start();
+    case_count++;
 
-    int res = !((fd[0] = fopen("/lfs/" "", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(1, res);
+#ifdef TEST_SHARED_MOUNT
+#if TEST_REFORMAT_EVERY
+    if (case_count % TEST_REFORMAT_EVERY == 0) {
+        int res = fs->unmount();
+        TEST_ASSERT_EQUAL(0, res);
 
-    deinit();
-}
+        format_and_mount();
+    }
+#endif
 
-//fopen empty file name with w mode
-static void FS_fopen_empty_path_w_mode()
-{
-    init();
+    snprintf(case_dir, sizeof(case_dir), "/%s/case_%u", test_fs_name(), (unsigned)case_count);
+    int res = mkdir(case_dir, 0777);
+    TEST_ASSERT_EQUAL(0, res);
+#else
+    snprintf(case_dir, sizeof(case_dir), "/%s", test_fs_name());
 
-    int res = !((fd[0] = fopen("/lfs/" "", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(1, res);
+    int res = counting_bd.init();
+    TEST_ASSERT_EQUAL(0, res);
 
-    deinit();
+    format_and_mount();
+#endif
+
+    counting_bd.reset();
+
+    // The memory of the block device and the file system is not the case's
+    memory_stats_case_start();
 }
 
-//fopen empty mode
-static void FS_fopen_invalid_mode()
+static void deinit()
 {
-    init();
+    memory_stats_case_end();
 
-    int res = !((fd[0] = fopen("/lfs/" "Invalid_mode", "")) != NULL);
-    TEST_ASSERT_EQUAL(1, res);
+#ifndef TEST_SHARED_MOUNT
+    int res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
 
-    deinit();
+    res = counting_bd.deinit();
+    TEST_ASSERT_EQUAL(0, res);
+#endif
+
+    posix_timing_print_case();
+    print_bd_traffic();
+    memory_stats_print_case();
+
+    TEST_ASSERT_EQUAL(0, memory_stats_case_leak());
 }
 
-//fopen with valid flow
-static void FS_fopen_supported_wb_mode()
+// Whether the heap and stack peaks since boot are within the budgets
+static bool within_memory_budget()
 {
-    init();
+    bool within = true;
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
+#if TEST_HEAP_BUDGET
+    if (memory_stats_heap_peak() > TEST_HEAP_BUDGET) {
+        printf("heap peak %lu B is over the budget of %lu B\n",
+               (unsigned long)memory_stats_heap_peak(), (unsigned long)TEST_HEAP_BUDGET);
+        within = false;
+    }
+#endif
+#if TEST_STACK_BUDGET
+    if (memory_stats_stack_peak() > TEST_STACK_BUDGET) {
+        printf("stack peak %lu B is over the budget of %lu B\n",
+               (unsigned long)memory_stats_stack_peak(), (unsigned long)TEST_STACK_BUDGET);
+        within = false;
+    }
+#endif
 
-    deinit();
+    return within;
 }
 
-//fopen with append mode
-static void FS_fopen_supported_a_mode()
+/*----------------fopen()------------------*/
+
+//fopen path without fs prefix
+static void FS_fopen_path_not_valid()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "a")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
+    int res = !((fd[0] = fopen("hello", "wb")) != NULL);
+    TEST_ASSERT_EQUAL(1, res);
 
     deinit();
 }
 
-//fopen with read mode
-static void FS_fopen_supported_r_mode()
+//fopen empty file name with r mode
+static void FS_fopen_empty_path_r_mode()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    int res = !((fd[0] = fopen(test_path(""), "rb")) != NULL);
     TEST_ASSERT_EQUAL(1, res);
 
     deinit();
 }
 
-//fopen with append update mode
-static void FS_fopen_supported_a_update_mode()
+//fopen empty file name with w mode
+static void FS_fopen_empty_path_w_mode()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "a+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
+    int res = !((fd[0] = fopen(test_path(""), "wb")) != NULL);
+    TEST_ASSERT_EQUAL(1, res);
 
     deinit();
 }
 
-//fopen with read update mode
-static void FS_fopen_supported_r_update_mode()
+//fopen empty mode
+static void FS_fopen_invalid_mode()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "r+")) != NULL);
+    int res = !((fd[0] = fopen(test_path("Invalid_mode"), "")) != NULL);
     TEST_ASSERT_EQUAL(1, res);
 
     deinit();
 }
 
-//fopen with write update mode
-static void FS_fopen_supported_w_update_mode()
+/* fopen a missing file in each of the FOPEN_MODES, the modes that create
+ * the file must succeed and the others must fail
+ */
+template <fopen_mode_id_t mode>
+static void FS_fopen_supported_mode()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
+    int res = !((fd[0] = fopen(test_path("hello"), fopen_modes[mode].mode)) != NULL);
+    TEST_ASSERT_EQUAL(!fopen_modes[mode].creates, res);
+
+    if (fd[0]) {
+        res = fclose(fd[0]);
+        TEST_ASSERT_EQUAL(0, res);
+    }
 
     deinit();
 }
@@ -216,7 +386,7 @@ static void FS_fopen_read_update_create()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), small_buf_size, fd[0]);
@@ -225,7 +395,7 @@ static void FS_fopen_read_update_create()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), small_buf_size, fd[0]);
@@ -246,7 +416,7 @@ static void FS_fopen_write_update_create()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), small_buf_size, fd[0]);
@@ -255,7 +425,7 @@ static void FS_fopen_write_update_create()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "w+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "w+")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), small_buf_size, fd[0]);
@@ -273,7 +443,7 @@ static void FS_fclose_valid_flow()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
@@ -291,7 +461,7 @@ static void FS_fwrite_nmemb_zero()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), 0, fd[0]);
@@ -311,7 +481,7 @@ static void FS_fwrite_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), small_buf_size, fd[0]);
@@ -320,7 +490,7 @@ static void FS_fwrite_valid_flow()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), small_buf_size, fd[0]);
@@ -340,13 +510,13 @@ static void FS_fwrite_with_fopen_r_mode()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
     
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -367,7 +537,7 @@ static void FS_fread_size_zero()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -376,7 +546,7 @@ static void FS_fread_size_zero()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(buffer, 0, small_buf_size, fd[0]);
@@ -395,7 +565,7 @@ static void FS_fread_nmemb_zero()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -404,7 +574,7 @@ static void FS_fread_nmemb_zero()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(buffer, sizeof(char), 0, fd[0]);
@@ -423,13 +593,13 @@ static void FS_fread_with_fopen_w_mode()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -449,7 +619,7 @@ static void FS_fread_to_fwrite_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), small_buf_size, fd[0]);
@@ -471,13 +641,13 @@ static void FS_fread_empty_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), small_buf_size, fd[0]);
@@ -497,7 +667,7 @@ static void FS_fread_valid_flow_small_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -506,7 +676,7 @@ static void FS_fread_valid_flow_small_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -528,7 +698,7 @@ static void FS_fread_valid_flow_medium_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -537,7 +707,7 @@ static void FS_fread_valid_flow_medium_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -558,7 +728,7 @@ static void FS_fread_valid_flow_large_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -567,7 +737,7 @@ static void FS_fread_valid_flow_large_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -588,7 +758,7 @@ static void FS_fread_valid_flow_small_file_read_more_than_write()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -597,7 +767,7 @@ static void FS_fread_valid_flow_small_file_read_more_than_write()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -617,13 +787,13 @@ static void FS_fgetc_empty_file()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fgetc(fd[0]);
@@ -645,7 +815,7 @@ static void FS_fgetc_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -654,7 +824,7 @@ static void FS_fgetc_valid_flow()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     for (i = 0; (i < (sizeof(read_buf)-1) && ((ch = fgetc(fd[0])) != EOF) && (ch != '\n')); i++) {
@@ -675,13 +845,13 @@ static void FS_fgetc_with_fopen_w_mode()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fgetc(fd[0]);
@@ -702,13 +872,13 @@ static void FS_fgets_empty_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NULL(fgets(buffer, sizeof(buffer), fd[0]));
@@ -724,13 +894,13 @@ static void FS_fgets_null_buffer_zero_len()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NULL(fgets(NULL, 0, fd[0]));
@@ -746,13 +916,13 @@ static void FS_fgets_null_buffer()
 {
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NULL(fgets(NULL, small_buf_size, fd[0]));
@@ -771,7 +941,7 @@ static void FS_fgets_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -780,7 +950,7 @@ static void FS_fgets_valid_flow()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NOT_NULL(fgets(read_buf, sizeof(read_buf), fd[0]));
@@ -802,7 +972,7 @@ static void FS_fgets_new_line()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -811,7 +981,7 @@ static void FS_fgets_new_line()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NOT_NULL(fgets(read_buf, sizeof(read_buf), fd[0]));
@@ -830,13 +1000,13 @@ static void FS_fgets_with_fopen_w_mode()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     TEST_ASSERT_NULL(fgets(buffer, sizeof(buffer), fd[0]));
@@ -868,7 +1038,7 @@ static void FS_fflush_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -891,7 +1061,7 @@ static void FS_fflush_twice()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(buffer, sizeof(char), small_buf_size, fd[0]);
@@ -918,7 +1088,7 @@ static void FS_fputc_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fputc(write_ch, fd[0]);
@@ -927,7 +1097,7 @@ static void FS_fputc_valid_flow()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     read_ch = fgetc(fd[0]);
@@ -946,13 +1116,13 @@ static void FS_fputc_in_read_mode()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fputc(write_ch, fd[0]);
@@ -974,7 +1144,7 @@ static void FS_fputs_valid_flow()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fputs(write_buf, fd[0]);
@@ -983,7 +1153,7 @@ static void FS_fputs_valid_flow()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -1003,13 +1173,13 @@ static void FS_fputs_in_read_mode()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fputs(buffer, fd[0]);
@@ -1023,25 +1193,58 @@ static void FS_fputs_in_read_mode()
 
 /*----------------fseek()------------------*/
 
-//fseek empty file, SEEK_SET, offset 0
-static void FS_fseek_empty_file_seek_set()
+/* fseek an empty or a non empty file from whence, to offset 0 the position
+ * must be the one of whence, beyond the end of the file fread must hit the
+ * end of the file, and back to the beginning from SEEK_END the position
+ * must be 0. The offsets and open modes are the ones of the cases the
+ * table replaced.
+ */
+template <int whence, seek_offset_t offset, bool non_empty>
+static void FS_fseek()
 {
+    char write_buf[small_buf_size] = "123456789";
+    char read_buf[small_buf_size] = {};
+    long file_size = non_empty ? sizeof(write_buf) : 0;
+
+    // The empty file beyond SEEK_SET case seeks a buffer size ahead, the others one byte
+    long beyond = non_empty ? file_size + 1 : (whence == SEEK_SET ? small_buf_size : 1);
+
+    // Seeking to the start of the file only needs it open for reading
+    const char *mode = whence == SEEK_SET && offset == SEEK_OFFSET_ZERO ? "rb" : "rb+";
+
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
+    if (non_empty) {
+        int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
+        TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
+    }
+
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), mode)) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], 0, SEEK_SET);
-    TEST_ASSERT_EQUAL(0, res);
+    if (offset == SEEK_OFFSET_BEYOND) {
+        res = fseek(fd[0], beyond, whence);
+        TEST_ASSERT_EQUAL(0, res);
+
+        int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
+        TEST_ASSERT_EQUAL(0, read_sz);
+
+        res = feof(fd[0]);
+        TEST_ASSERT_NOT_EQUAL(0, res);
+    } else {
+        res = fseek(fd[0], offset == SEEK_OFFSET_NEGATIVE ? -file_size : 0, whence);
+        TEST_ASSERT_EQUAL(0, res);
 
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
+        long expected = whence == SEEK_END && offset == SEEK_OFFSET_ZERO ? file_size : 0;
+        int pos = ftell(fd[0]);
+        TEST_ASSERT_EQUAL(expected, pos);
+    }
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -1049,30 +1252,42 @@ static void FS_fseek_empty_file_seek_set()
     deinit();
 }
 
-//fseek non empty file, SEEK_SET, offset 0
-static void FS_fseek_non_empty_file_seek_set()
+/*----------------fgetpos()------------------*/
+
+//fgetpos rewrite file and check data
+static void FS_fgetpos_rewrite_check_data()
 {
     char write_buf[small_buf_size] = "123456789";
+    char rewrite_buf[small_buf_size] = "987654321";
+    char read_buf[small_buf_size] = {};
+    fpos_t pos;
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fgetpos(fd[0], &pos);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
     TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
 
-    res = fclose(fd[0]);
+    res = fsetpos(fd[0], &pos);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
+    write_sz = fwrite(rewrite_buf, sizeof(char), sizeof(rewrite_buf), fd[0]);
+    TEST_ASSERT_EQUAL(sizeof(rewrite_buf), write_sz);
+
+    res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], 0, SEEK_SET);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
+    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
+    TEST_ASSERT_EQUAL(sizeof(rewrite_buf), read_sz);
+    TEST_ASSERT_EQUAL_STRING(rewrite_buf, read_buf);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -1080,30 +1295,36 @@ static void FS_fseek_non_empty_file_seek_set()
     deinit();
 }
 
-//fseek empty file, SEEK_SET, offset 1 - beyond end of file
-static void FS_fseek_beyond_empty_file_seek_set()
+/*----------------fscanf()------------------*/
+
+//fscanf valid flow
+static void FS_fscanf_valid_flow()
 {
-    char read_buf[small_buf_size] = "";
+    char write_buf[small_buf_size] = "123456789";
+    char read_buf[small_buf_size] = {};
+    int num = 0;
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
+    res = fprintf(fd[0], "%d %s", 123, write_buf);
+    TEST_ASSERT_EQUAL(3 + sizeof(write_buf), res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
+    res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], 10, SEEK_SET);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
+    res = fscanf(fd[0], "%d", &num);
+    TEST_ASSERT_EQUAL(1, res);
+    TEST_ASSERT_EQUAL_INT(123, num);
 
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
+    res = fscanf(fd[0], "%s", read_buf);
+    TEST_ASSERT_EQUAL(1, res);
+    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -1111,34 +1332,18 @@ static void FS_fseek_beyond_empty_file_seek_set()
     deinit();
 }
 
-//fseek non empty file, SEEK_SET, offset data_size + 1 - beyond end of file
-static void FS_fseek_beyond_non_empty_file_seek_set()
+//fscanf empty file
+static void FS_fscanf_empty_file()
 {
-    char write_buf[small_buf_size] = "123456789";
-    char read_buf[small_buf_size] = "";
+    int num = 0;
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], sizeof(write_buf) + 1, SEEK_SET);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
-
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
+    res = fscanf(fd[0], "%d", &num);
+    TEST_ASSERT_EQUAL(EOF, res);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -1146,480 +1351,105 @@ static void FS_fseek_beyond_non_empty_file_seek_set()
     deinit();
 }
 
-//fseek empty file, SEEK_CUR, offset 0
-static void FS_fseek_empty_file_seek_cur()
+//fscanf more fields than exist
+static void FS_fscanf_more_fields_than_exist()
 {
+    char write_buf[small_buf_size] = "123456789";
+    char read_buf[small_buf_size] = {};
+    int num = 0;
+
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
+    res = fprintf(fd[0], "%d %s", 123, write_buf);
+    TEST_ASSERT_EQUAL(3 + sizeof(write_buf), res);
+
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], 0, SEEK_CUR);
-    TEST_ASSERT_EQUAL(0, res);
+    res = fscanf(fd[0], "%d", &num);
+    TEST_ASSERT_EQUAL(1, res);
+    TEST_ASSERT_EQUAL_INT(123, num);
 
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
+    res = fscanf(fd[0], "%s", read_buf);
+    TEST_ASSERT_EQUAL(1, res);
+    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
 
+    res = fscanf(fd[0], "%d", &num);
+    TEST_ASSERT_EQUAL(EOF, res);
+    
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
     deinit();
 }
 
-//fseek non empty file, SEEK_CUR, offset 0
-static void FS_fseek_non_empty_file_seek_cur()
-{
-    char write_buf[small_buf_size] = "123456789";
+/*----------------fprintf()------------------*/
 
+//fprintf in mode r
+static void FS_fprintf_read_mode()
+{
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], 0, SEEK_CUR);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
-
+    res = fprintf(fd[0], "%d", 123);
+    TEST_ASSERT_NOT_EQUAL(1, res);
+    
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
     deinit();
 }
 
-//fseek empty file, SEEK_CUR, offset 1 - beyond end of file
-static void FS_fseek_beyond_empty_file_seek_cur()
+/*----------------freopen()------------------*/
+
+//freopen point to the same file with two file handler
+static void FS_freopen_point_to_same_file()
 {
-    char read_buf[small_buf_size] = {};
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = fseek(fd[0], 1, SEEK_CUR);
+    res = !((fd[1] = freopen(test_path("new_file_name"), "wb", fd[0])) != NULL);
     TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
-
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
-
+    
+    TEST_ASSERT_EQUAL(fd[0], fd[1]);
+    
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
     deinit();
 }
 
-//fseek non empty file, SEEK_CUR, offset data_size + 1 - beyond end of file
-static void FS_fseek_beyond_non_empty_file_seek_cur()
+//freopen valid flow
+static void FS_freopen_valid_flow()
 {
-    char read_buf[small_buf_size] = {};
     char write_buf[small_buf_size] = "123456789";
+    char read_buf[small_buf_size] = {};
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "wb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
     TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
 
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], sizeof(write_buf) + 1, SEEK_CUR);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
-
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fseek empty file, SEEK_END, offset 0
-static void FS_fseek_empty_file_seek_end()
-{
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], 0, SEEK_END);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fseek non empty file, SEEK_END, offset 0
-static void FS_fseek_non_empty_file_seek_end()
-{
-    char write_buf[small_buf_size] = "123456789";
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], 0, SEEK_END);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(write_sz, pos);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fseek empty file, SEEK_END, offset 1 - beyond end of file
-static void FS_fseek_beyond_empty_file_seek_end()
-{
-    char read_buf[small_buf_size] = {};
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], 1, SEEK_END);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
-
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fseek non empty file, SEEK_END, offset data_size + 1 - beyond end of file
-static void FS_fseek_beyond_non_empty_file_seek_end()
-{
-    char read_buf[small_buf_size] = {};
-    char write_buf[small_buf_size] = "123456789";
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], sizeof(write_buf) + 1, SEEK_END);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(0, read_sz);
-
-    res = feof(fd[0]);
-    TEST_ASSERT_NOT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fseek non empty file, SEEK_END, offset negative
-static void FS_fseek_negative_non_empty_file_seek_end()
-{
-    char write_buf[small_buf_size] = "123456789";
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fseek(fd[0], -(sizeof(write_buf)), SEEK_END);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int pos = ftell(fd[0]);
-    TEST_ASSERT_EQUAL(0, pos);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-/*----------------fgetpos()------------------*/
-
-//fgetpos rewrite file and check data
-static void FS_fgetpos_rewrite_check_data()
-{
-    char write_buf[small_buf_size] = "123456789";
-    char rewrite_buf[small_buf_size] = "987654321";
-    char read_buf[small_buf_size] = {};
-    fpos_t pos;
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fgetpos(fd[0], &pos);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fsetpos(fd[0], &pos);
-    TEST_ASSERT_EQUAL(0, res);
-
-    write_sz = fwrite(rewrite_buf, sizeof(char), sizeof(rewrite_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(rewrite_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(rewrite_buf), read_sz);
-    TEST_ASSERT_EQUAL_STRING(rewrite_buf, read_buf);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-/*----------------fscanf()------------------*/
-
-//fscanf valid flow
-static void FS_fscanf_valid_flow()
-{
-    char write_buf[small_buf_size] = "123456789";
-    char read_buf[small_buf_size] = {};
-    int num = 0;
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fprintf(fd[0], "%d %s", 123, write_buf);
-    TEST_ASSERT_EQUAL(3 + sizeof(write_buf), res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fscanf(fd[0], "%d", &num);
-    TEST_ASSERT_EQUAL(1, res);
-    TEST_ASSERT_EQUAL_INT(123, num);
-
-    res = fscanf(fd[0], "%s", read_buf);
-    TEST_ASSERT_EQUAL(1, res);
-    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fscanf empty file
-static void FS_fscanf_empty_file()
-{
-    int num = 0;
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fscanf(fd[0], "%d", &num);
-    TEST_ASSERT_EQUAL(EOF, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//fscanf more fields than exist
-static void FS_fscanf_more_fields_than_exist()
-{
-    char write_buf[small_buf_size] = "123456789";
-    char read_buf[small_buf_size] = {};
-    int num = 0;
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fprintf(fd[0], "%d %s", 123, write_buf);
-    TEST_ASSERT_EQUAL(3 + sizeof(write_buf), res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fscanf(fd[0], "%d", &num);
-    TEST_ASSERT_EQUAL(1, res);
-    TEST_ASSERT_EQUAL_INT(123, num);
-
-    res = fscanf(fd[0], "%s", read_buf);
-    TEST_ASSERT_EQUAL(1, res);
-    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
-
-    res = fscanf(fd[0], "%d", &num);
-    TEST_ASSERT_EQUAL(EOF, res);
-    
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-/*----------------fprintf()------------------*/
-
-//fprintf in mode r
-static void FS_fprintf_read_mode()
-{
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = fprintf(fd[0], "%d", 123);
-    TEST_ASSERT_NOT_EQUAL(1, res);
-    
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-/*----------------freopen()------------------*/
-
-//freopen point to the same file with two file handler
-static void FS_freopen_point_to_same_file()
-{
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[1] = freopen("/lfs/" "new_file_name", "wb", fd[0])) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-    
-    TEST_ASSERT_EQUAL(fd[0], fd[1]);
-    
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//freopen valid flow
-static void FS_freopen_valid_flow()
-{
-    char write_buf[small_buf_size] = "123456789";
-    char read_buf[small_buf_size] = {};
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "wb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = !((fd[1] = freopen("/lfs/" "hello", "rb", fd[0])) != NULL);
+    res = !((fd[1] = freopen(test_path("hello"), "rb", fd[0])) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -1634,152 +1464,50 @@ static void FS_freopen_valid_flow()
 
 /*----------------general------------------*/
 
-//create a 1 byte file
-static void FS_fopen_write_one_byte_file()
-{
-    char write_buf = 1;
-    char read_buf[1] = {};
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(&write_buf, sizeof(char), 1, fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), read_sz);
-    TEST_ASSERT_EQUAL(write_buf, read_buf[0]);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//create a 2 bytes file
-static void FS_fopen_write_two_byte_file()
-{
-    char write_buf[2] = "1";
-    char read_buf[2] = {};
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), read_sz);
-    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//create a 5 bytes file
-static void FS_fopen_write_five_byte_file()
-{
-    char write_buf[5] = "1234";
-    char read_buf[5] = {};
-
-    init();
-
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), read_sz);
-    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    deinit();
-}
-
-//create a 15 bytes file
-static void FS_fopen_write_fifteen_byte_file()
+/* create a file of size bytes in one of the WRITE_MODES and read all of it
+ * back, sizes beyond half of the device are reported as ignored
+ */
+template <write_mode_id_t mode, size_t size>
+static void FS_fopen_write_file()
 {
-    char write_buf[15] = "12345678901234";
-    char read_buf[15] = {};
+    PatternGenerator writer(PatternGenerator::run_seed());
+    PatternGenerator reader(PatternGenerator::run_seed());
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), write_sz);
-
-    res = fclose(fd[0]);
-    TEST_ASSERT_EQUAL(0, res);
-
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(write_buf), read_sz);
-    TEST_ASSERT_EQUAL_STRING(write_buf, read_buf);
+    // The device size is only known once it is initialized
+    if (size > bd.size() / 2) {
+        deinit();
+        printf("SKIPPED: file size %lu B is above half of the %llu B device\n",
+               (unsigned long)size, (unsigned long long)bd.size());
+        TEST_IGNORE_MESSAGE("file too large for this device");
+        return;
+    }
 
-    res = fclose(fd[0]);
+    int res = !((fd[0] = fopen(test_path("hello"), write_modes[mode])) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    deinit();
-}
-
-//create a 5000 bytes file
-static void FS_fopen_write_five_Kbyte_file()
-{
-    int buf_sz = 5000;
-    char *write_buf = (char *)malloc(buf_sz);
-    char read_buf[10] = {};
-    char check_buf[10] = "123456789";
-
-    init();
+    for (size_t pos = 0; pos < size; pos += sizeof(chunk_buf)) {
+        size_t chunk = size - pos < sizeof(chunk_buf) ? size - pos : sizeof(chunk_buf);
+        writer.fill(chunk_buf, chunk);
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
-    TEST_ASSERT_EQUAL(0, res);
-
-    memcpy(write_buf, check_buf, sizeof(check_buf) - 1);
-    int write_sz = fwrite(write_buf, sizeof(char), buf_sz, fd[0]);
-    TEST_ASSERT_EQUAL(buf_sz, write_sz);
+        int write_sz = fwrite(chunk_buf, sizeof(char), chunk, fd[0]);
+        TEST_ASSERT_EQUAL(chunk, write_sz);
+    }
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "rb+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "rb")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
-    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf) - 1, fd[0]);
-    TEST_ASSERT_EQUAL(sizeof(check_buf) - 1, read_sz);
-    TEST_ASSERT_EQUAL_STRING(check_buf, read_buf);
+    size_t read_total = 0;
+    size_t read_sz;
+    while ((read_sz = fread(chunk_buf, sizeof(char), sizeof(chunk_buf), fd[0])) > 0) {
+        TEST_ASSERT_EQUAL(PatternGenerator::MATCH, reader.check(chunk_buf, read_sz));
+        read_total += read_sz;
+    }
+    TEST_ASSERT_EQUAL(size, read_total);
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -1797,7 +1525,7 @@ static void FS_fseek_rewrite_non_empty_file_begining()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -1806,7 +1534,7 @@ static void FS_fseek_rewrite_non_empty_file_begining()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r+")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 0, SEEK_SET);
@@ -1818,7 +1546,7 @@ static void FS_fseek_rewrite_non_empty_file_begining()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 0, SEEK_SET);
@@ -1844,7 +1572,7 @@ static void FS_fseek_rewrite_non_empty_file_middle()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -1853,7 +1581,7 @@ static void FS_fseek_rewrite_non_empty_file_middle()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r+")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 5, SEEK_SET);
@@ -1865,7 +1593,7 @@ static void FS_fseek_rewrite_non_empty_file_middle()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 0, SEEK_SET);
@@ -1891,7 +1619,7 @@ static void FS_fseek_rewrite_non_empty_file_end()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -1900,7 +1628,7 @@ static void FS_fseek_rewrite_non_empty_file_end()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r+")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 9, SEEK_SET);
@@ -1912,7 +1640,7 @@ static void FS_fseek_rewrite_non_empty_file_end()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     res = fseek(fd[0], 0, SEEK_SET);
@@ -1936,7 +1664,7 @@ static void FS_append_empty_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "a")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "a")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf), fd[0]);
@@ -1945,7 +1673,7 @@ static void FS_append_empty_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd[0]);
@@ -1968,7 +1696,7 @@ static void FS_append_non_empty_file()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "a")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "a")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     int write_sz = fwrite(write_buf, sizeof(char), sizeof(write_buf) - 1, fd[0]);
@@ -1977,7 +1705,7 @@ static void FS_append_non_empty_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    res = !((fd[0] = fopen("/lfs/" "hello", "a+")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "a+")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     write_sz = fwrite(rewrite_buf, sizeof(char), sizeof(rewrite_buf), fd[0]);
@@ -1986,7 +1714,7 @@ static void FS_append_non_empty_file()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
     
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     memcpy(check_buf, write_buf, sizeof(write_buf) - 1);
@@ -2002,35 +1730,41 @@ static void FS_append_non_empty_file()
     deinit();
 }
 
-//fill write_buf buffer with random data, read back the data from the file
+//write seeded random data a byte at a time, read back the data from the file and check it
 static void FS_write_read_random_data()
 {
-    char write_buf[medium_buf_size] = {};
+    PatternGenerator writer(PatternGenerator::run_seed());
+    PatternGenerator reader(PatternGenerator::run_seed());
+    uint8_t data;
     unsigned int i;
 
     init();
 
-    // Fill write_buf buffer with random data and write the data into the file
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    // Write the random data into the file
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     for (i = 0; i < medium_buf_size; i++) {
-        write_buf[i] = rand() % 0XFF;
-        res = fprintf(fd[0], "%c", write_buf[i]);
+        writer.fill(&data, 1);
+        res = fprintf(fd[0], "%c", data);
         TEST_ASSERT_EQUAL(1, res);
     }
-    
+
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
 
-    // Read back the data from the file and store them in data_read
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    // Read back the data from the file and check it against the same stream
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     for (i = 0; i < medium_buf_size; i++) {
-        uint8_t data = fgetc(fd[0]);
-        TEST_ASSERT_EQUAL(write_buf[i], data);
+        res = fgetc(fd[0]);
+        TEST_ASSERT_NOT_EQUAL(EOF, res);
+
+        data = res;
+        TEST_ASSERT_EQUAL(PatternGenerator::MATCH, reader.check(&data, 1));
     }
+    TEST_ASSERT_EQUAL_HEX32(writer.crc(), reader.crc());
 
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
@@ -2045,7 +1779,7 @@ static void FS_fill_data_and_seek()
 
     init();
 
-    int res = !((fd[0] = fopen("/lfs/" "hello", "w")) != NULL);
+    int res = !((fd[0] = fopen(test_path("hello"), "w")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     for (i = 0; i < 256; i++) {
@@ -2056,7 +1790,7 @@ static void FS_fill_data_and_seek()
     res = fclose(fd[0]);
     TEST_ASSERT_EQUAL(0, res);
     
-    res = !((fd[0] = fopen("/lfs/" "hello", "r")) != NULL);
+    res = !((fd[0] = fopen(test_path("hello"), "r")) != NULL);
     TEST_ASSERT_EQUAL(0, res);
 
     for (i = 1; i <= 255; i++) {
@@ -2091,115 +1825,262 @@ static void FS_fill_data_and_seek()
 
 /*----------------setup------------------*/
 
-Case cases[] = {
-    Case("FS_write_read_random_data", FS_write_read_random_data),
-    Case("FS_fill_data_and_seek", FS_fill_data_and_seek),
-
-
-    Case("FS_fopen_path_not_valid", FS_fopen_path_not_valid),
-    Case("FS_fopen_empty_path_r_mode", FS_fopen_empty_path_r_mode),
-    Case("FS_fopen_empty_path_w_mode", FS_fopen_empty_path_w_mode),
-    Case("FS_fopen_invalid_mode", FS_fopen_invalid_mode),
-    Case("FS_fopen_supported_wb_mode", FS_fopen_supported_wb_mode),
-    Case("FS_fopen_supported_a_mode", FS_fopen_supported_a_mode),
-    Case("FS_fopen_supported_r_mode", FS_fopen_supported_r_mode),
-    Case("FS_fopen_supported_a_update_mode", FS_fopen_supported_a_update_mode),
-    Case("FS_fopen_supported_r_update_mode", FS_fopen_supported_r_update_mode),
-    Case("FS_fopen_supported_w_update_mode", FS_fopen_supported_w_update_mode),
-    Case("FS_fopen_read_update_create", FS_fopen_read_update_create),
-    Case("FS_fopen_write_update_create", FS_fopen_write_update_create),
-
-    Case("FS_fclose_valid_flow", FS_fclose_valid_flow),
-
-    Case("FS_fwrite_nmemb_zero", FS_fwrite_nmemb_zero),
-    Case("FS_fwrite_valid_flow", FS_fwrite_valid_flow),
-    Case("FS_fwrite_with_fopen_r_mode", FS_fwrite_with_fopen_r_mode),
-
-    Case("FS_fread_size_zero", FS_fread_size_zero),
-    Case("FS_fread_nmemb_zero", FS_fread_nmemb_zero),
-    Case("FS_fread_with_fopen_w_mode", FS_fread_with_fopen_w_mode),
-    Case("FS_fread_to_fwrite_file", FS_fread_to_fwrite_file),
-    Case("FS_fread_empty_file", FS_fread_empty_file),
-    Case("FS_fread_valid_flow_small_file", FS_fread_valid_flow_small_file),
-    Case("FS_fread_valid_flow_medium_file", FS_fread_valid_flow_medium_file),
-    Case("FS_fread_valid_flow_large_file", FS_fread_valid_flow_large_file),
-    Case("FS_fread_valid_flow_small_file_read_more_than_write", FS_fread_valid_flow_small_file_read_more_than_write),
-
-    Case("FS_fgetc_empty_file", FS_fgetc_empty_file),
-    Case("FS_fgetc_valid_flow", FS_fgetc_valid_flow),
-    Case("FS_fgetc_with_fopen_w_mode", FS_fgetc_with_fopen_w_mode),
-
-    Case("FS_fgets_empty_file", FS_fgets_empty_file),
-    Case("FS_fgets_null_buffer_zero_len", FS_fgets_null_buffer_zero_len),
-    Case("FS_fgets_null_buffer", FS_fgets_null_buffer),
-    Case("FS_fgets_valid_flow", FS_fgets_valid_flow),
-    Case("FS_fgets_new_line", FS_fgets_new_line),
-    Case("FS_fgets_with_fopen_w_mode", FS_fgets_with_fopen_w_mode),
-
-    Case("FS_fflush_null_stream", FS_fflush_null_stream),
-    Case("FS_fflush_valid_flow", FS_fflush_valid_flow),
-    Case("FS_fflush_twice", FS_fflush_twice),
-
-    Case("FS_fputc_valid_flow", FS_fputc_valid_flow),
-    Case("FS_fputc_in_read_mode", FS_fputc_in_read_mode),
-
-    Case("FS_fputs_valid_flow", FS_fputs_valid_flow),
-    Case("FS_fputs_in_read_mode", FS_fputs_in_read_mode),
-
-    Case("FS_fseek_empty_file_seek_set", FS_fseek_empty_file_seek_set),
-    Case("FS_fseek_non_empty_file_seek_set", FS_fseek_non_empty_file_seek_set),
-    Case("FS_fseek_empty_file_seek_set", FS_fseek_beyond_empty_file_seek_set),
-    Case("FS_fseek_beyond_non_empty_file_seek_set", FS_fseek_beyond_non_empty_file_seek_set),
-    Case("FS_fseek_empty_file_seek_cur", FS_fseek_empty_file_seek_cur),
-    Case("FS_fseek_non_empty_file_seek_cur", FS_fseek_non_empty_file_seek_cur),
-    Case("FS_fseek_empty_file_seek_cur", FS_fseek_beyond_empty_file_seek_cur),
-    Case("FS_fseek_beyond_non_empty_file_seek_cur", FS_fseek_beyond_non_empty_file_seek_cur),
-    Case("FS_fseek_empty_file_seek_end", FS_fseek_empty_file_seek_end),
-    Case("FS_fseek_non_empty_file_seek_end", FS_fseek_non_empty_file_seek_end),
-    Case("FS_fseek_empty_file_seek_end", FS_fseek_beyond_empty_file_seek_end),
-    Case("FS_fseek_beyond_non_empty_file_seek_end", FS_fseek_beyond_non_empty_file_seek_end),
-    Case("FS_fseek_negative_non_empty_file_seek_end", FS_fseek_negative_non_empty_file_seek_end),
-
-    Case("FS_fgetpos_rewrite_check_data", FS_fgetpos_rewrite_check_data),
-
-    Case("FS_fscanf_valid_flow", FS_fscanf_valid_flow),
-    Case("FS_fscanf_empty_file", FS_fscanf_empty_file),
-    Case("FS_fscanf_more_fields_than_exist", FS_fscanf_more_fields_than_exist),
-
-    Case("FS_fprintf_read_mode", FS_fprintf_read_mode),
-
-    Case("FS_freopen_point_to_same_file", FS_freopen_point_to_same_file),
-    Case("FS_freopen_valid_flow", FS_freopen_valid_flow),
-
-    Case("FS_fopen_write_one_byte_file", FS_fopen_write_one_byte_file),
-    Case("FS_fopen_write_two_byte_file", FS_fopen_write_two_byte_file),
-    Case("FS_fopen_write_five_byte_file", FS_fopen_write_five_byte_file),
-    Case("FS_fopen_write_fifteen_byte_file", FS_fopen_write_fifteen_byte_file),
-    Case("FS_fopen_write_five_Kbyte_file", FS_fopen_write_five_Kbyte_file),
-
-    Case("FS_fseek_rewrite_non_empty_file_begining", FS_fseek_rewrite_non_empty_file_begining),
-    Case("FS_fseek_rewrite_non_empty_file_middle", FS_fseek_rewrite_non_empty_file_middle),
-    Case("FS_fseek_rewrite_non_empty_file_end", FS_fseek_rewrite_non_empty_file_end),
-
-    Case("FS_append_empty_file", FS_append_empty_file),
-    Case("FS_append_non_empty_file", FS_append_non_empty_file),
-
-    /*Case("FS_write_read_random_data", FS_write_read_random_data),
-    Case("FS_fill_data_and_seek", FS_fill_data_and_seek),*/
+/* Every case runs once with FAT and once with LittleFS, the FAT cases come
+ * first. CASE(name, handler) is expanded once for each file system.
+ */
+#define FS_TEST_CASES(CASE) \
+    CASE("FS_write_read_random_data", FS_write_read_random_data) \
+    CASE("FS_fill_data_and_seek", FS_fill_data_and_seek) \
+    \
+    CASE("FS_fopen_path_not_valid", FS_fopen_path_not_valid) \
+    CASE("FS_fopen_empty_path_r_mode", FS_fopen_empty_path_r_mode) \
+    CASE("FS_fopen_empty_path_w_mode", FS_fopen_empty_path_w_mode) \
+    CASE("FS_fopen_invalid_mode", FS_fopen_invalid_mode) \
+    FOPEN_MODES(FOPEN_MODE_CASE, CASE) \
+    CASE("FS_fopen_read_update_create", FS_fopen_read_update_create) \
+    CASE("FS_fopen_write_update_create", FS_fopen_write_update_create) \
+    \
+    CASE("FS_fclose_valid_flow", FS_fclose_valid_flow) \
+    \
+    CASE("FS_fwrite_nmemb_zero", FS_fwrite_nmemb_zero) \
+    CASE("FS_fwrite_valid_flow", FS_fwrite_valid_flow) \
+    CASE("FS_fwrite_with_fopen_r_mode", FS_fwrite_with_fopen_r_mode) \
+    \
+    CASE("FS_fread_size_zero", FS_fread_size_zero) \
+    CASE("FS_fread_nmemb_zero", FS_fread_nmemb_zero) \
+    CASE("FS_fread_with_fopen_w_mode", FS_fread_with_fopen_w_mode) \
+    CASE("FS_fread_to_fwrite_file", FS_fread_to_fwrite_file) \
+    CASE("FS_fread_empty_file", FS_fread_empty_file) \
+    CASE("FS_fread_valid_flow_small_file", FS_fread_valid_flow_small_file) \
+    CASE("FS_fread_valid_flow_medium_file", FS_fread_valid_flow_medium_file) \
+    CASE("FS_fread_valid_flow_large_file", FS_fread_valid_flow_large_file) \
+    CASE("FS_fread_valid_flow_small_file_read_more_than_write", FS_fread_valid_flow_small_file_read_more_than_write) \
+    \
+    CASE("FS_fgetc_empty_file", FS_fgetc_empty_file) \
+    CASE("FS_fgetc_valid_flow", FS_fgetc_valid_flow) \
+    CASE("FS_fgetc_with_fopen_w_mode", FS_fgetc_with_fopen_w_mode) \
+    \
+    CASE("FS_fgets_empty_file", FS_fgets_empty_file) \
+    CASE("FS_fgets_null_buffer_zero_len", FS_fgets_null_buffer_zero_len) \
+    CASE("FS_fgets_null_buffer", FS_fgets_null_buffer) \
+    CASE("FS_fgets_valid_flow", FS_fgets_valid_flow) \
+    CASE("FS_fgets_new_line", FS_fgets_new_line) \
+    CASE("FS_fgets_with_fopen_w_mode", FS_fgets_with_fopen_w_mode) \
+    \
+    CASE("FS_fflush_null_stream", FS_fflush_null_stream) \
+    CASE("FS_fflush_valid_flow", FS_fflush_valid_flow) \
+    CASE("FS_fflush_twice", FS_fflush_twice) \
+    \
+    CASE("FS_fputc_valid_flow", FS_fputc_valid_flow) \
+    CASE("FS_fputc_in_read_mode", FS_fputc_in_read_mode) \
+    \
+    CASE("FS_fputs_valid_flow", FS_fputs_valid_flow) \
+    CASE("FS_fputs_in_read_mode", FS_fputs_in_read_mode) \
+    \
+    SEEK_WHENCES(SEEK_WHENCE_CASES, CASE) \
+    CASE("FS_fseek_negative_non_empty_file_seek_end", (FS_fseek<SEEK_END, SEEK_OFFSET_NEGATIVE, true>)) \
+    \
+    CASE("FS_fgetpos_rewrite_check_data", FS_fgetpos_rewrite_check_data) \
+    \
+    CASE("FS_fscanf_valid_flow", FS_fscanf_valid_flow) \
+    CASE("FS_fscanf_empty_file", FS_fscanf_empty_file) \
+    CASE("FS_fscanf_more_fields_than_exist", FS_fscanf_more_fields_than_exist) \
+    \
+    CASE("FS_fprintf_read_mode", FS_fprintf_read_mode) \
+    \
+    CASE("FS_freopen_point_to_same_file", FS_freopen_point_to_same_file) \
+    CASE("FS_freopen_valid_flow", FS_freopen_valid_flow) \
+    \
+    WRITE_MODES(WRITE_MODE_CASES, CASE) \
+    \
+    CASE("FS_fseek_rewrite_non_empty_file_begining", FS_fseek_rewrite_non_empty_file_begining) \
+    CASE("FS_fseek_rewrite_non_empty_file_middle", FS_fseek_rewrite_non_empty_file_middle) \
+    CASE("FS_fseek_rewrite_non_empty_file_end", FS_fseek_rewrite_non_empty_file_end) \
+    \
+    CASE("FS_append_empty_file", FS_append_empty_file) \
+    CASE("FS_append_non_empty_file", FS_append_non_empty_file)
+
+#define CASE_NAME(name, handler) name,
+#define FAT_CASE(name, handler) Case("FAT_" name, fs_case_setup, handler, fs_case_teardown),
+#define LFS_CASE(name, handler) Case("LFS_" name, fs_case_setup, handler, fs_case_teardown),
+
+static const char *const case_names[] = {
+    FS_TEST_CASES(CASE_NAME)
 };
 
+static const size_t num_cases = sizeof(case_names) / sizeof(case_names[0]);
+
+// Cases of this shard, as indexes into cases
+static const size_t shard_start = TEST_FS_COUNT * num_cases * TEST_SHARD / TEST_SHARDS;
+static const size_t shard_end = TEST_FS_COUNT * num_cases * (TEST_SHARD + 1) / TEST_SHARDS;
+
+// Time spent in the timed calls and block device traffic of every case
+struct case_stats_t {
+    uint32_t time_us;
+    uint32_t read_bytes;
+    uint32_t program_bytes;
+    uint32_t erase_bytes;
+};
+
+static case_stats_t case_stats[TEST_FS_COUNT][num_cases];
+static size_t current_case = 0;
+
+static bool case_in_shard = false;
+
+#ifdef TEST_SHARED_MOUNT
+static bool mounted = false;
+#endif
+
+static bool in_shard(size_t index)
+{
+    return index >= shard_start && index < shard_end;
+}
+
+static utest::v1::status_t fs_case_setup(const Case *const source, const size_t index_of_case)
+{
+    // Cases of other shards are reported as ignored, without touching the file system
+    size_t index = index_of_case;
+    case_in_shard = in_shard(index);
+    if (!case_in_shard) {
+        return STATUS_IGNORE;
+    }
+
+    test_fs_t type = index < num_cases ? TEST_FS_FAT : TEST_FS_LFS;
+    current_case = index % num_cases;
+
+#ifdef TEST_SHARED_MOUNT
+    // The shared volume is formatted again when the file system changes
+    if (!mounted || type != test_fs_type()) {
+        if (mounted && fs->unmount()) {
+            return STATUS_ABORT;
+        }
+        mounted = false;
+
+        test_fs_select(type);
+        if (test_fs_format(&counting_bd) || fs->mount(&counting_bd)) {
+            return STATUS_ABORT;
+        }
+        mounted = true;
+    }
+#else
+    test_fs_select(type);
+#endif
+
+    perf_report_case(source->get_description());
+
+    return greentea_case_setup_handler(source, index_of_case);
+}
+
+static utest::v1::status_t fs_case_teardown(const Case *const source, const size_t passed, const size_t failed, const failure_t reason)
+{
+    if (!case_in_shard) {
+        return STATUS_CONTINUE;
+    }
+
+    case_stats_t &stats = case_stats[test_fs_type()][current_case];
+
+    stats.time_us = 0;
+    for (int op = 0; op < TIMING_OPS; op++) {
+        stats.time_us += posix_timing_case((posix_timing_op_t)op).total();
+    }
+    stats.read_bytes = counting_bd.get_read_bytes();
+    stats.program_bytes = counting_bd.get_program_bytes();
+    stats.erase_bytes = counting_bd.get_erase_bytes();
+
+    posix_timing_report_case();
+    perf_report(stats.time_us, "time_us");
+    perf_report(counting_bd.get_read_count(), "bd_read_count");
+    perf_report(counting_bd.get_read_bytes(), "bd_read_bytes");
+    perf_report(counting_bd.get_program_count(), "bd_program_count");
+    perf_report(counting_bd.get_program_bytes(), "bd_program_bytes");
+    perf_report(counting_bd.get_erase_count(), "bd_erase_count");
+    perf_report(counting_bd.get_erase_bytes(), "bd_erase_bytes");
+    perf_report(counting_bd.get_sync_count(), "bd_sync_count");
+    memory_stats_report_case();
+
+    return greentea_case_teardown_handler(source, passed, failed, reason);
+}
+
+/* Print the time and traffic of every case with both file systems side by
+ * side, cases of other shards are left out
+ */
+static void print_comparison()
+{
+    printf("%-52s %9s %9s %9s %9s %9s %9s\n", "case",
+           "FAT us", "LFS us", "FAT prog", "LFS prog", "FAT erase", "LFS erase");
+
+    for (size_t i = 0; i < num_cases; i++) {
+        if (!in_shard(i) && !in_shard(num_cases + i)) {
+            continue;
+        }
+
+        const case_stats_t &fat = case_stats[TEST_FS_FAT][i];
+        const case_stats_t &lfs = case_stats[TEST_FS_LFS][i];
+
+        printf("%-52s %9lu %9lu %9lu %9lu %9lu %9lu\n", case_names[i],
+               (unsigned long)fat.time_us, (unsigned long)lfs.time_us,
+               (unsigned long)fat.program_bytes, (unsigned long)lfs.program_bytes,
+               (unsigned long)fat.erase_bytes, (unsigned long)lfs.erase_bytes);
+    }
+}
+
+Case cases[] = {
+    FS_TEST_CASES(FAT_CASE)
+    FS_TEST_CASES(LFS_CASE)
+};
 
 utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
 {
-    GREENTEA_SETUP(3000, "default_auto");
+    GREENTEA_SETUP(6000, "default_auto");
+
+    memory_stats_warm_up();
+
+    // Allocate the storage of a RAM backed device now, not in the case that first writes it
+    if (test_bd_allocate()) {
+        return STATUS_ABORT;
+    }
+
+#if TEST_SHARDS > 1
+    printf("shard %d of %d, cases %lu to %lu\n", TEST_SHARD, TEST_SHARDS,
+           (unsigned long)shard_start, (unsigned long)shard_end - 1);
+#endif
+
+    printf("random data seed %lu, build with -DTEST_SEED=%lu to repeat it\n",
+           (unsigned long)PatternGenerator::run_seed(), (unsigned long)PatternGenerator::run_seed());
+
+#ifdef TEST_SHARED_MOUNT
+    int res = counting_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+#endif
+
     return greentea_test_setup_handler(number_of_cases);
 }
 
-Specification specification(greentea_test_setup, cases, greentea_test_teardown_handler);
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+#ifdef TEST_SHARED_MOUNT
+    if (mounted) {
+        fs->unmount();
+    }
+    counting_bd.deinit();
+#endif
+
+    posix_timing_print_total();
+    print_comparison();
+
+    memory_stats_print_run();
+    perf_report_case("run");
+    memory_stats_report_run();
+
+    // The peaks only grow, so a run over the budget counts as one more failure
+    greentea_test_teardown_handler(passed, within_memory_budget() ? failed : failed + 1, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown);
 
 int main()
 {
-    bool res = !Harness::run(specification);
-    delete fs;
-    return res;
+    return !Harness::run(specification);
 }
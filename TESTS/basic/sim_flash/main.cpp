@@ -0,0 +1,193 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "SimFlashBlockDevice.h"
+#include "PatternGenerator.h"
+
+using namespace utest::v1;
+
+// Bytes written to the file the remount cases read back, spans several erase blocks
+#ifndef SIM_FILE_SIZE
+#define SIM_FILE_SIZE (16 * 1024)
+#endif
+
+static const size_t path_size = 32;
+
+// The contents are checked, not the timing, so the devices do not wait
+static const sim_flash_timing_t no_timing = {0, 0, 0, 0, 0};
+
+// Geometry of the simulated parts, the presets of TEST_SIM_NOR and TEST_SIM_SD
+struct sim_part_t {
+    bd_size_t read_size;
+    bd_size_t program_size;
+    bd_size_t erase_size;
+    bd_size_t page_size;
+    bd_size_t block_count;
+    int erase_value;
+};
+
+enum sim_part_id_t {
+    SIM_PART_NOR,
+    SIM_PART_SD
+};
+
+static const sim_part_t sim_parts[] = {
+    {1, 1, 4096, 256, 32, 0xff},
+    {512, 512, 512, 512, 256, -1},
+};
+
+FILE *fd;
+
+static uint8_t chunk_buf[512];
+
+/*----------------remount------------------*/
+
+/* Format a simulated device, write a file, unmount, deinit and init the
+ * device, remount and read the file back. format, mount and unmount
+ * deinit and init the device on their own, so the contents must survive
+ * every deinit.
+ */
+template <sim_part_id_t id, test_fs_t type>
+void SIM_remount_read_back()
+{
+    const sim_part_t &part = sim_parts[id];
+    SimFlashBlockDevice sim_bd(part.block_count * part.erase_size, part.read_size, part.program_size,
+                               part.erase_size, part.page_size, no_timing, part.erase_value);
+    PatternGenerator writer(PatternGenerator::run_seed());
+    PatternGenerator reader(PatternGenerator::run_seed());
+    char file_path[path_size];
+
+    test_fs_select(type);
+    snprintf(file_path, sizeof(file_path), "/%s/sim", test_fs_name());
+
+    int res = test_fs_format(&sim_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&sim_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = !((fd = fopen(file_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t written = 0; written < SIM_FILE_SIZE; written += sizeof(chunk_buf)) {
+        writer.fill(chunk_buf, sizeof(chunk_buf));
+        int write_sz = fwrite(chunk_buf, sizeof(char), sizeof(chunk_buf), fd);
+        TEST_ASSERT_EQUAL(sizeof(chunk_buf), write_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.init();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.deinit();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&sim_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = !((fd = fopen(file_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t read = 0; read < SIM_FILE_SIZE; read += sizeof(chunk_buf)) {
+        int read_sz = fread(chunk_buf, sizeof(char), sizeof(chunk_buf), fd);
+        TEST_ASSERT_EQUAL(sizeof(chunk_buf), read_sz);
+        TEST_ASSERT_EQUAL(PatternGenerator::MATCH, reader.check(chunk_buf, sizeof(chunk_buf)));
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    TEST_ASSERT_EQUAL(writer.crc(), reader.crc());
+
+    res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------erase------------------*/
+
+//program over programmed bytes of the NOR part fails until the block is erased
+void SIM_NOR_program_needs_erase()
+{
+    const sim_part_t &part = sim_parts[SIM_PART_NOR];
+    SimFlashBlockDevice sim_bd(part.block_count * part.erase_size, part.read_size, part.program_size,
+                               part.erase_size, part.page_size, no_timing, part.erase_value);
+    char read_buf[6] = {};
+
+    int res = sim_bd.init();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.program("hello", 0, 6);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.program("world", 0, 6);
+    TEST_ASSERT_EQUAL(BD_ERROR_DEVICE_ERROR, res);
+
+    res = sim_bd.erase(0, part.erase_size);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.program("world", 0, 6);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.deinit();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.init();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = sim_bd.read(read_buf, 0, 6);
+    TEST_ASSERT_EQUAL(0, res);
+    TEST_ASSERT_EQUAL_STRING("world", read_buf);
+
+    res = sim_bd.deinit();
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("SIM_NOR_FAT_remount_read_back", SIM_remount_read_back<SIM_PART_NOR, TEST_FS_FAT>),
+    Case("SIM_NOR_LFS_remount_read_back", SIM_remount_read_back<SIM_PART_NOR, TEST_FS_LFS>),
+    Case("SIM_SD_FAT_remount_read_back", SIM_remount_read_back<SIM_PART_SD, TEST_FS_FAT>),
+    Case("SIM_SD_LFS_remount_read_back", SIM_remount_read_back<SIM_PART_SD, TEST_FS_LFS>),
+
+    Case("SIM_NOR_program_needs_erase", SIM_NOR_program_needs_erase),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(300, "default_auto");
+
+    printf("random data seed %lu, build with -DTEST_SEED=%lu to repeat it\n",
+           (unsigned long)PatternGenerator::run_seed(), (unsigned long)PatternGenerator::run_seed());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+Specification specification(greentea_test_setup, cases);
+
+int main()
+{
+    return !Harness::run(specification);
+}
@@ -0,0 +1,346 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "CountingBlockDevice.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Writes and reads done for every length and offset
+#ifndef ALIGNMENT_REPEATS
+#define ALIGNMENT_REPEATS 8
+#endif
+
+// Longer accesses are skipped
+#ifndef ALIGNMENT_MAX_LENGTH
+#define ALIGNMENT_MAX_LENGTH (16 * 1024)
+#endif
+
+// Fewer records are written when they take more than this percent of the free space
+#ifndef ALIGNMENT_MAX_FILL_PERCENT
+#define ALIGNMENT_MAX_FILL_PERCENT 75
+#endif
+
+static const size_t max_offsets = 6;
+
+// Result of the accesses of one length at one offset
+struct access_result_t {
+    double write_mbps;
+    double read_mbps;
+    double programs;    // block device programs per write
+    double erases;      // block device erases per write
+    double reads;       // block device reads per read
+};
+
+static uint8_t buffer[ALIGNMENT_MAX_LENGTH];
+static char bench_path[32];
+
+// Counts the block device operations of every access
+CountingBlockDevice counting_bd(&bd);
+
+// Whether the selected file system is mounted, the cases switch between them
+static bool mounted = false;
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+/* Format and mount the device with a file system, unless it is mounted
+ * already. The file system mounted before is unmounted first.
+ */
+static void mount_fs(test_fs_t type)
+{
+    if (mounted && type == test_fs_type()) {
+        return;
+    }
+
+    if (mounted) {
+        int res = fs->unmount();
+        TEST_ASSERT_EQUAL(0, res);
+        mounted = false;
+    }
+
+    test_fs_select(type);
+
+    int res = test_fs_format(&counting_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&counting_bd);
+    TEST_ASSERT_EQUAL(0, res);
+    mounted = true;
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/records", test_fs_name());
+}
+
+// Bytes the file system has free, or the device size when it cannot tell
+static bd_size_t free_space()
+{
+    struct statvfs st;
+    if (fs->statvfs("", &st)) {
+        return bd.size();
+    }
+    return (bd_size_t)st.f_bavail * st.f_frsize;
+}
+
+// Space between the starts of two records, the next multiple of the erase size
+static size_t record_stride(size_t length, size_t offset)
+{
+    size_t erase_size = bd.get_erase_size();
+    return (offset + length + erase_size - 1) / erase_size * erase_size;
+}
+
+/* File offsets from a multiple of the erase size the accesses start at:
+ * aligned, one byte off, one program unit off and a quarter, half and all
+ * but one byte of an erase block off. Offsets that repeat or reach the next
+ * multiple are left out. Returns the number of offsets.
+ */
+static size_t access_offsets(size_t *offsets)
+{
+    size_t erase_size = bd.get_erase_size();
+    size_t candidates[max_offsets] = {
+        0, 1, (size_t)bd.get_program_size(), erase_size / 4, erase_size / 2, erase_size - 1
+    };
+    size_t count = 0;
+
+    for (size_t i = 0; i < max_offsets; i++) {
+        bool repeated = false;
+        for (size_t j = 0; j < count; j++) {
+            repeated = repeated || offsets[j] == candidates[i];
+        }
+
+        if (!repeated && candidates[i] < erase_size) {
+            offsets[count++] = candidates[i];
+        }
+    }
+
+    return count;
+}
+
+// Make the written data durable, fflush hands it to the file system and fsync commits it
+static int commit()
+{
+    int res = fflush(fd);
+    if (res) {
+        return res;
+    }
+    return fsync(fileno(fd));
+}
+
+/* Rewrite repeats records of length bytes at offset bytes past a multiple
+ * of the erase size in the file, committing every record, then read them
+ * back. Every record starts at its own multiple, so every record has the
+ * same file offset within it. Where that lands on the device is up to the
+ * file system.
+ */
+static void run_access(size_t length, size_t offset, size_t repeats, access_result_t &result)
+{
+    size_t stride = record_stride(length, offset);
+
+    // The file is created before, so the records rewrite data in place
+    memset(buffer, 0, sizeof(buffer));
+
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t pos = 0; pos < repeats * stride; pos += sizeof(buffer)) {
+        size_t size = repeats * stride - pos < sizeof(buffer) ? repeats * stride - pos : sizeof(buffer);
+        int write_sz = fwrite(buffer, sizeof(char), size, fd);
+        TEST_ASSERT_EQUAL(size, write_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = !((fd = fopen(bench_path, "r+")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    // Only the file calls are timed, the timer adds up the time across start and stop
+    counting_bd.reset();
+    Timer timer;
+
+    for (size_t i = 0; i < repeats; i++) {
+        memset(buffer, i + 1, length);
+
+        timer.start();
+        res = fseek(fd, i * stride + offset, SEEK_SET);
+        TEST_ASSERT_EQUAL(0, res);
+
+        int write_sz = fwrite(buffer, sizeof(char), length, fd);
+        TEST_ASSERT_EQUAL(length, write_sz);
+
+        res = commit();
+        timer.stop();
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    result.write_mbps = (double)repeats * length / timer.read_high_resolution_us();
+    result.programs = (double)counting_bd.get_program_count() / repeats;
+    result.erases = (double)counting_bd.get_erase_count() / repeats;
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    // Reopen the file so the reads start with no data cached
+    res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    counting_bd.reset();
+    timer.reset();
+
+    for (size_t i = 0; i < repeats; i++) {
+        timer.start();
+        res = fseek(fd, i * stride + offset, SEEK_SET);
+        int read_sz = fread(buffer, sizeof(char), length, fd);
+        timer.stop();
+
+        TEST_ASSERT_EQUAL(0, res);
+        TEST_ASSERT_EQUAL(length, read_sz);
+
+        size_t mismatches = 0;
+        for (size_t j = 0; j < length; j++) {
+            mismatches += buffer[j] != (uint8_t)(i + 1);
+        }
+        TEST_ASSERT_EQUAL(0, mismatches);
+    }
+
+    result.read_mbps = (double)repeats * length / timer.read_high_resolution_us();
+    result.reads = (double)counting_bd.get_read_count() / repeats;
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------alignment------------------*/
+
+/* write and read records of num / den erase blocks plus extra bytes at every
+ * file offset with a file system, and print the slowdown and the extra block
+ * device operations against the records at file offset 0
+ */
+template <test_fs_t type, unsigned num, unsigned den, unsigned extra>
+void FS_alignment()
+{
+    mount_fs(type);
+
+    size_t length = bd.get_erase_size() * num / den + extra;
+    if (length > ALIGNMENT_MAX_LENGTH) {
+        printf("SKIPPED: length %lu B is above ALIGNMENT_MAX_LENGTH\n", (unsigned long)length);
+        TEST_IGNORE_MESSAGE("record longer than ALIGNMENT_MAX_LENGTH");
+        return;
+    }
+
+    size_t offsets[max_offsets];
+    size_t num_offsets = access_offsets(offsets);
+    access_result_t aligned = {};
+
+    // All offsets write the same number of records, as many as fit with the longest stride
+    size_t max_stride = 0;
+    for (size_t i = 0; i < num_offsets; i++) {
+        size_t stride = record_stride(length, offsets[i]);
+        max_stride = stride > max_stride ? stride : max_stride;
+    }
+    bd_size_t fill = free_space() * ALIGNMENT_MAX_FILL_PERCENT / 100;
+    size_t repeats = ALIGNMENT_REPEATS;
+    if (repeats * max_stride > fill) {
+        repeats = fill / max_stride;
+        if (!repeats) {
+            printf("SKIPPED: a record stride of %lu B is above %d%% of the free space\n",
+                   (unsigned long)max_stride, ALIGNMENT_MAX_FILL_PERCENT);
+            TEST_IGNORE_MESSAGE("record does not fit the file system");
+            return;
+        }
+        printf("%lu records of the %d, more do not fit the file system\n",
+               (unsigned long)repeats, ALIGNMENT_REPEATS);
+    }
+
+    printf("%8s %8s | %9s %7s %8s %8s | %9s %7s %8s\n", "length", "file off",
+           "write", "slower", "programs", "erases", "read", "slower", "reads");
+
+    for (size_t i = 0; i < num_offsets; i++) {
+        access_result_t result;
+        run_access(length, offsets[i], repeats, result);
+
+        if (offsets[i] == 0) {
+            aligned = result;
+        }
+
+        printf("%8lu %8lu | %9.3f %6.2fx %8.1f %8.1f | %9.3f %6.2fx %8.1f\n",
+               (unsigned long)length, (unsigned long)offsets[i],
+               result.write_mbps, aligned.write_mbps / result.write_mbps, result.programs, result.erases,
+               result.read_mbps, aligned.read_mbps / result.read_mbps, result.reads);
+
+        unsigned long offset = offsets[i];
+        perf_report(result.write_mbps, "file_offset_%lu_write_mbps", offset);
+        perf_report(result.read_mbps, "file_offset_%lu_read_mbps", offset);
+        perf_report(result.programs, "file_offset_%lu_programs_count", offset);
+        perf_report(result.erases, "file_offset_%lu_erases_count", offset);
+        perf_report(result.reads, "file_offset_%lu_reads_count", offset);
+    }
+    printf("MB/s, slowdown against file offset 0, block device operations per access\n");
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FAT_alignment_half_erase_size", FS_alignment<TEST_FS_FAT, 1, 2, 0>),
+    Case("FAT_alignment_erase_size", FS_alignment<TEST_FS_FAT, 1, 1, 0>),
+    Case("FAT_alignment_erase_size_plus_one", FS_alignment<TEST_FS_FAT, 1, 1, 1>),
+    Case("FAT_alignment_four_erase_sizes", FS_alignment<TEST_FS_FAT, 4, 1, 0>),
+
+    Case("LFS_alignment_half_erase_size", FS_alignment<TEST_FS_LFS, 1, 2, 0>),
+    Case("LFS_alignment_erase_size", FS_alignment<TEST_FS_LFS, 1, 1, 0>),
+    Case("LFS_alignment_erase_size_plus_one", FS_alignment<TEST_FS_LFS, 1, 1, 1>),
+    Case("LFS_alignment_four_erase_sizes", FS_alignment<TEST_FS_LFS, 4, 1, 0>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = counting_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    printf("%s geometry: read %llu B, program %llu B, erase %llu B\n", test_bd_name(),
+           (unsigned long long)bd.get_read_size(), (unsigned long long)bd.get_program_size(),
+           (unsigned long long)bd.get_erase_size());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    if (mounted) {
+        fs->unmount();
+    }
+    counting_bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
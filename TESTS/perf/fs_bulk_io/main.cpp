@@ -0,0 +1,327 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "CountingBlockDevice.h"
+#include "perf_report.h"
+#include "PatternGenerator.h"
+
+using namespace utest::v1;
+
+// Bytes written and read back by every method
+#ifndef BULK_PAYLOAD_SIZE
+#define BULK_PAYLOAD_SIZE (16 * 1024)
+#endif
+
+// Bytes passed to a single call by the chunked methods
+#ifndef BULK_CHUNK_SIZE
+#define BULK_CHUNK_SIZE 512
+#endif
+
+static const size_t path_size = 32;
+
+// Ways the payload is written and read back
+enum io_method_t {
+    IO_FPRINTF,
+    IO_FPUTC,
+    IO_FWRITE,
+    IO_FILE_BYTE,
+    IO_FILE_CHUNK,
+    IO_METHODS
+};
+
+static const char *const method_names[IO_METHODS] = {
+    "fprintf/fgetc", "fputc/fgetc", "fwrite/fread", "File byte", "File chunk"
+};
+
+/* Results of the write and the read phase. The elapsed cycles include the
+ * time the core waited for the storage, the cycles outside the block device
+ * leave the time spent in block device calls out, which is the CPU cost of
+ * the stdio layer and the file system.
+ */
+struct io_result_t {
+    bool done;
+    uint32_t time_us[2];
+    uint32_t elapsed_cycles[2];
+    uint32_t outside_bd_cycles[2];
+};
+
+static io_result_t results[IO_METHODS];
+
+static uint8_t payload[BULK_PAYLOAD_SIZE];
+static uint8_t read_buf[BULK_PAYLOAD_SIZE];
+static char bench_path[path_size];
+static const char *const bench_name = "bench";
+
+// Times the block device calls, to leave them out of the cycles of the file calls
+CountingBlockDevice counting_bd(&bd);
+
+FILE *fd;
+
+/*----------------cycle counter------------------*/
+
+/* The DWT cycle counter of Cortex-M3 and up counts every core clock, on cores
+ * without it the cycles are derived from the elapsed time. The counter wraps
+ * every 2^32 cycles, longer phases are reported from the elapsed time as well.
+ */
+static void cycle_counter_init()
+{
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static uint32_t cycle_counter_read()
+{
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    return DWT->CYCCNT;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t cycles_elapsed(uint32_t start_cycles, uint32_t time_us)
+{
+    uint64_t time_cycles = (uint64_t)time_us * (SystemCoreClock / 1000000);
+
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+    if (time_cycles < 0xffffffffULL / 2) {
+        return cycle_counter_read() - start_cycles;
+    }
+#endif
+    return time_cycles > 0xffffffffULL ? 0xffffffff : (uint32_t)time_cycles;
+}
+
+/*----------------help functions------------------*/
+
+static void stdio_write(io_method_t method)
+{
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    if (method == IO_FPRINTF) {
+        // One call per byte, as in FS_write_read_random_data
+        for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i++) {
+            res = fprintf(fd, "%c", payload[i]);
+            TEST_ASSERT_EQUAL(1, res);
+        }
+    } else if (method == IO_FPUTC) {
+        // One call per byte, as in FS_fill_data_and_seek
+        for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i++) {
+            res = fputc(payload[i], fd);
+            TEST_ASSERT_EQUAL(payload[i], res);
+        }
+    } else {
+        for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i += BULK_CHUNK_SIZE) {
+            int write_sz = fwrite(&payload[i], sizeof(char), BULK_CHUNK_SIZE, fd);
+            TEST_ASSERT_EQUAL(BULK_CHUNK_SIZE, write_sz);
+        }
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+static void stdio_read(io_method_t method)
+{
+    int res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    if (method == IO_FWRITE) {
+        for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i += BULK_CHUNK_SIZE) {
+            int read_sz = fread(&read_buf[i], sizeof(char), BULK_CHUNK_SIZE, fd);
+            TEST_ASSERT_EQUAL(BULK_CHUNK_SIZE, read_sz);
+        }
+    } else {
+        for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i++) {
+            res = fgetc(fd);
+            TEST_ASSERT_NOT_EQUAL(EOF, res);
+            read_buf[i] = res;
+        }
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+// The File API calls the file system directly, with no FILE buffering
+static void file_write(io_method_t method)
+{
+    File file;
+    size_t chunk_size = method == IO_FILE_BYTE ? 1 : BULK_CHUNK_SIZE;
+
+    int res = file.open(fs, bench_name, O_WRONLY | O_CREAT | O_TRUNC);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i += chunk_size) {
+        ssize_t write_sz = file.write(&payload[i], chunk_size);
+        TEST_ASSERT_EQUAL(chunk_size, write_sz);
+    }
+
+    res = file.close();
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+static void file_read(io_method_t method)
+{
+    File file;
+    size_t chunk_size = method == IO_FILE_BYTE ? 1 : BULK_CHUNK_SIZE;
+
+    int res = file.open(fs, bench_name, O_RDONLY);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t i = 0; i < BULK_PAYLOAD_SIZE; i += chunk_size) {
+        ssize_t read_sz = file.read(&read_buf[i], chunk_size);
+        TEST_ASSERT_EQUAL(chunk_size, read_sz);
+    }
+
+    res = file.close();
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+static void print_result(io_method_t method, int dir)
+{
+    const io_result_t &result = results[method];
+    const io_result_t &base = results[IO_FWRITE];
+
+    printf("%-5s %-14s %9.3f MB/s %12lu cycles %12lu outside bd %8.1f cycles/B", dir ? "read" : "write",
+           method_names[method], (double)BULK_PAYLOAD_SIZE / (double)result.time_us[dir],
+           (unsigned long)result.elapsed_cycles[dir], (unsigned long)result.outside_bd_cycles[dir],
+           (double)result.outside_bd_cycles[dir] / BULK_PAYLOAD_SIZE);
+    if (base.done) {
+        printf(" %6.2fx fwrite/fread time", (double)result.time_us[dir] / (double)base.time_us[dir]);
+    }
+    printf("\n");
+}
+
+/*----------------bulk io------------------*/
+
+//write the payload with the method, read it back with the matching method and check it
+template <io_method_t method>
+void FS_bulk_io()
+{
+    bool raw = method == IO_FILE_BYTE || method == IO_FILE_CHUNK;
+    io_result_t &result = results[method];
+
+    memset(read_buf, 0, sizeof(read_buf));
+
+    for (int dir = 0; dir < 2; dir++) {
+        counting_bd.reset();
+        Timer timer;
+        timer.start();
+        uint32_t start_cycles = cycle_counter_read();
+
+        if (dir == 0) {
+            raw ? file_write(method) : stdio_write(method);
+        } else {
+            raw ? file_read(method) : stdio_read(method);
+        }
+
+        timer.stop();
+        result.time_us[dir] = timer.read_us();
+        result.elapsed_cycles[dir] = cycles_elapsed(start_cycles, result.time_us[dir]);
+
+        uint64_t bd_cycles = counting_bd.get_busy_us() * (SystemCoreClock / 1000000);
+        result.outside_bd_cycles[dir] = result.elapsed_cycles[dir] > bd_cycles ?
+                                        (uint32_t)(result.elapsed_cycles[dir] - bd_cycles) : 0;
+    }
+
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payload, read_buf, BULK_PAYLOAD_SIZE);
+    result.done = true;
+
+    print_result(method, 0);
+    print_result(method, 1);
+
+    perf_report((double)BULK_PAYLOAD_SIZE / (double)result.time_us[0], "write_mbps");
+    perf_report(result.elapsed_cycles[0], "write_elapsed_cycles");
+    perf_report(result.outside_bd_cycles[0], "write_outside_bd_cycles");
+    perf_report((double)BULK_PAYLOAD_SIZE / (double)result.time_us[1], "read_mbps");
+    perf_report(result.elapsed_cycles[1], "read_elapsed_cycles");
+    perf_report(result.outside_bd_cycles[1], "read_outside_bd_cycles");
+
+    int res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_bulk_io_fwrite_chunks", FS_bulk_io<IO_FWRITE>),
+    Case("FS_bulk_io_fprintf_per_byte", FS_bulk_io<IO_FPRINTF>),
+    Case("FS_bulk_io_fputc_per_byte", FS_bulk_io<IO_FPUTC>),
+    Case("FS_bulk_io_File_per_byte", FS_bulk_io<IO_FILE_BYTE>),
+    Case("FS_bulk_io_File_chunks", FS_bulk_io<IO_FILE_CHUNK>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(1200, "default_auto");
+
+    PatternGenerator pattern(PatternGenerator::run_seed());
+    pattern.fill(payload, BULK_PAYLOAD_SIZE);
+
+    cycle_counter_init();
+
+    int res = counting_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/%s", test_fs_name(), bench_name);
+
+    printf("random data seed %lu, build with -DTEST_SEED=%lu to repeat it\n",
+           (unsigned long)PatternGenerator::run_seed(), (unsigned long)PatternGenerator::run_seed());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    counting_bd.deinit();
+
+    printf("\n");
+    for (int method = 0; method < IO_METHODS; method++) {
+        if (results[method].done) {
+            print_result((io_method_t)method, 0);
+            print_result((io_method_t)method, 1);
+        }
+    }
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
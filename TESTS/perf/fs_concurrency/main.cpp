@@ -0,0 +1,331 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "rtos.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Bytes every worker writes and reads
+#ifndef CONCURRENCY_FILE_SIZE
+#define CONCURRENCY_FILE_SIZE (16 * 1024)
+#endif
+
+// Bytes passed to a single fwrite/fread call
+#ifndef CONCURRENCY_CHUNK_SIZE
+#define CONCURRENCY_CHUNK_SIZE 512
+#endif
+
+#ifndef CONCURRENCY_STACK_SIZE
+#define CONCURRENCY_STACK_SIZE 4096
+#endif
+
+// Cases whose files take more than this percent of the device are skipped
+#ifndef CONCURRENCY_MAX_FILL_PERCENT
+#define CONCURRENCY_MAX_FILL_PERCENT 50
+#endif
+
+static const size_t max_workers = 8;
+static const size_t path_size = 32;
+
+// Steps a worker can fail in, reported by the main thread
+enum worker_error_t {
+    WORKER_OK,
+    WORKER_FOPEN,
+    WORKER_FSEEK,
+    WORKER_FWRITE,
+    WORKER_FREAD,
+    WORKER_DATA,
+    WORKER_FCLOSE
+};
+
+struct worker_t {
+    int id;
+    char path[path_size];
+    long offset;
+    worker_error_t error;
+    uint32_t in_call_us;
+};
+
+static worker_t workers[max_workers];
+
+/*----------------help functions------------------*/
+
+static uint8_t pattern(int id, size_t pos)
+{
+    return (uint8_t)(id * 31 + pos);
+}
+
+// Write CONCURRENCY_FILE_SIZE bytes to the worker's own file
+static void worker_write(worker_t *worker)
+{
+    uint8_t buffer[CONCURRENCY_CHUNK_SIZE];
+
+    uint32_t start = us_ticker_read();
+    FILE *file = fopen(worker->path, "w");
+    worker->in_call_us += us_ticker_read() - start;
+    if (!file) {
+        worker->error = WORKER_FOPEN;
+        return;
+    }
+
+    for (size_t pos = 0; pos < CONCURRENCY_FILE_SIZE; pos += sizeof(buffer)) {
+        for (size_t i = 0; i < sizeof(buffer); i++) {
+            buffer[i] = pattern(worker->id, pos + i);
+        }
+
+        start = us_ticker_read();
+        size_t write_sz = fwrite(buffer, sizeof(char), sizeof(buffer), file);
+        worker->in_call_us += us_ticker_read() - start;
+        if (write_sz != sizeof(buffer)) {
+            worker->error = WORKER_FWRITE;
+            break;
+        }
+    }
+
+    start = us_ticker_read();
+    int res = fclose(file);
+    worker->in_call_us += us_ticker_read() - start;
+    if (res && worker->error == WORKER_OK) {
+        worker->error = WORKER_FCLOSE;
+    }
+}
+
+// Read CONCURRENCY_FILE_SIZE bytes starting at the worker's offset and check them
+static void worker_read(worker_t *worker)
+{
+    uint8_t buffer[CONCURRENCY_CHUNK_SIZE];
+
+    uint32_t start = us_ticker_read();
+    FILE *file = fopen(worker->path, "r");
+    worker->in_call_us += us_ticker_read() - start;
+    if (!file) {
+        worker->error = WORKER_FOPEN;
+        return;
+    }
+
+    start = us_ticker_read();
+    int res = fseek(file, worker->offset, SEEK_SET);
+    worker->in_call_us += us_ticker_read() - start;
+    if (res) {
+        worker->error = WORKER_FSEEK;
+    }
+
+    for (size_t pos = 0; pos < CONCURRENCY_FILE_SIZE && worker->error == WORKER_OK; pos += sizeof(buffer)) {
+        start = us_ticker_read();
+        size_t read_sz = fread(buffer, sizeof(char), sizeof(buffer), file);
+        worker->in_call_us += us_ticker_read() - start;
+        if (read_sz != sizeof(buffer)) {
+            worker->error = WORKER_FREAD;
+            break;
+        }
+
+        for (size_t i = 0; i < sizeof(buffer); i++) {
+            if (buffer[i] != pattern(worker->id, pos + i)) {
+                worker->error = WORKER_DATA;
+                break;
+            }
+        }
+    }
+
+    start = us_ticker_read();
+    res = fclose(file);
+    worker->in_call_us += us_ticker_read() - start;
+    if (res && worker->error == WORKER_OK) {
+        worker->error = WORKER_FCLOSE;
+    }
+}
+
+// Whether the files of num_workers workers fit the device, prints a notice when they do not
+static bool fits(size_t num_workers)
+{
+    uint64_t total = (uint64_t)num_workers * CONCURRENCY_FILE_SIZE;
+    if (total <= bd.size() / 100 * CONCURRENCY_MAX_FILL_PERCENT) {
+        return true;
+    }
+
+    printf("SKIPPED: %lu files of %lu B do not fit on this device\n",
+           (unsigned long)num_workers, (unsigned long)CONCURRENCY_FILE_SIZE);
+    return false;
+}
+
+/* Run the function in num_workers threads at once and print the aggregate
+ * throughput. The time the workers spent inside calls beyond the elapsed
+ * time is the overlap of their calls. It is an estimate of the contention,
+ * not a measured lock wait: the file systems serialize their calls with a
+ * mutex that cannot be timed from here, and the overlap also holds the time
+ * a worker was preempted inside a call for any other reason.
+ */
+static void run_workers(const char *op, size_t num_workers, void (*func)(worker_t *))
+{
+    Thread *threads[max_workers];
+
+    for (size_t i = 0; i < num_workers; i++) {
+        workers[i].error = WORKER_OK;
+        workers[i].in_call_us = 0;
+    }
+
+    uint32_t start = us_ticker_read();
+
+    for (size_t i = 0; i < num_workers; i++) {
+        threads[i] = new Thread(osPriorityNormal, CONCURRENCY_STACK_SIZE);
+        osStatus status = threads[i]->start(callback(func, &workers[i]));
+        TEST_ASSERT_EQUAL(osOK, status);
+    }
+
+    for (size_t i = 0; i < num_workers; i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    uint32_t elapsed_us = us_ticker_read() - start;
+
+    uint64_t in_call_us = 0;
+    for (size_t i = 0; i < num_workers; i++) {
+        TEST_ASSERT_EQUAL(WORKER_OK, workers[i].error);
+        in_call_us += workers[i].in_call_us;
+    }
+
+    uint64_t overlap_us = in_call_us > elapsed_us ? in_call_us - elapsed_us : 0;
+    double mb_per_s = (double)num_workers * CONCURRENCY_FILE_SIZE / (double)elapsed_us;
+
+    printf("%-5s threads %lu: %9.3f MB/s, elapsed %10lu us, overlap %10llu us (%5.1f%% of time in calls)\n",
+           op, (unsigned long)num_workers, mb_per_s, (unsigned long)elapsed_us,
+           (unsigned long long)overlap_us, in_call_us ? 100.0 * overlap_us / in_call_us : 0.0);
+    perf_report(mb_per_s, "%s_mbps", op);
+    perf_report(overlap_us, "%s_call_overlap_us", op);
+}
+
+/*----------------concurrency------------------*/
+
+//every worker writes and reads back a file of its own
+template <size_t num_workers>
+void FS_concurrent_private_files()
+{
+    if (!fits(num_workers)) {
+        TEST_IGNORE_MESSAGE("files do not fit on this device");
+        return;
+    }
+
+    for (size_t i = 0; i < num_workers; i++) {
+        workers[i].id = i;
+        workers[i].offset = 0;
+        snprintf(workers[i].path, path_size, "/%s/thread_%u", test_fs_name(), (unsigned)i);
+    }
+
+    run_workers("write", num_workers, worker_write);
+    run_workers("read", num_workers, worker_read);
+
+    for (size_t i = 0; i < num_workers; i++) {
+        int res = remove(workers[i].path);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+}
+
+/* every worker reads its own stripe of one file through a handle of its own,
+ * the file is written by a single thread before as concurrent writers of one
+ * file have no defined result on LittleFS
+ */
+template <size_t num_workers>
+void FS_concurrent_shared_file()
+{
+    if (!fits(num_workers)) {
+        TEST_IGNORE_MESSAGE("file does not fit on this device");
+        return;
+    }
+
+    char path[path_size];
+    snprintf(path, path_size, "/%s/shared", test_fs_name());
+
+    for (size_t i = 0; i < num_workers; i++) {
+        workers[i].id = i;
+        workers[i].offset = i * CONCURRENCY_FILE_SIZE;
+        strcpy(workers[i].path, path);
+    }
+
+    FILE *file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+
+    for (size_t i = 0; i < num_workers; i++) {
+        for (size_t pos = 0; pos < CONCURRENCY_FILE_SIZE; pos++) {
+            int res = fputc(pattern(i, pos), file);
+            TEST_ASSERT_EQUAL(pattern(i, pos), res);
+        }
+    }
+
+    int res = fclose(file);
+    TEST_ASSERT_EQUAL(0, res);
+
+    run_workers("read", num_workers, worker_read);
+
+    res = remove(path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_concurrent_private_files_1_thread", FS_concurrent_private_files<1>),
+    Case("FS_concurrent_private_files_2_threads", FS_concurrent_private_files<2>),
+    Case("FS_concurrent_private_files_4_threads", FS_concurrent_private_files<4>),
+    Case("FS_concurrent_private_files_8_threads", FS_concurrent_private_files<8>),
+
+    Case("FS_concurrent_shared_file_1_thread", FS_concurrent_shared_file<1>),
+    Case("FS_concurrent_shared_file_2_threads", FS_concurrent_shared_file<2>),
+    Case("FS_concurrent_shared_file_4_threads", FS_concurrent_shared_file<4>),
+    Case("FS_concurrent_shared_file_8_threads", FS_concurrent_shared_file<8>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(1200, "default_auto");
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
@@ -0,0 +1,246 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "AccessPattern.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+/* Records are LOGGER_RECORD_SIZE bytes, or of random sizes up to
+ * LOGGER_RECORD_MAX_SIZE when it is larger
+ */
+#ifndef LOGGER_RECORD_SIZE
+#define LOGGER_RECORD_SIZE 64
+#endif
+
+#ifndef LOGGER_RECORD_MAX_SIZE
+#define LOGGER_RECORD_MAX_SIZE LOGGER_RECORD_SIZE
+#endif
+
+// Time the logger runs at every rate
+#ifndef LOGGER_DURATION_MS
+#define LOGGER_DURATION_MS 5000
+#endif
+
+// The logger has fallen behind once a record is this late
+#ifndef LOGGER_MAX_LAG_MS
+#define LOGGER_MAX_LAG_MS 500
+#endif
+
+// The log is stopped before it grows beyond this fraction (in percent) of the device
+#ifndef LOGGER_MAX_FILL_PERCENT
+#define LOGGER_MAX_FILL_PERCENT 50
+#endif
+
+// Target rates in records per second, tried in turn until the logger falls behind
+static const uint32_t rates[] = {
+    10, 100, 1000, 10000
+};
+
+static const size_t num_rates = sizeof(rates) / sizeof(rates[0]);
+
+static char record[LOGGER_RECORD_MAX_SIZE];
+static char log_path[32];
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+// A text line of size bytes, ending in a newline
+static void fill_record(uint32_t seq, size_t size)
+{
+    memset(record, 'x', size);
+    int len = snprintf(record, size, "%08lu ", (unsigned long)seq);
+    if (len >= (int)size) {
+        len = size - 1;
+    }
+    record[len] = ' ';
+    record[size - 1] = '\n';
+}
+
+// Make the buffered records durable, fflush hands them to the file system and fsync commits them
+static int flush_log()
+{
+    int res = fflush(fd);
+    if (res) {
+        return res;
+    }
+    return fsync(fileno(fd));
+}
+
+/* Append records at rate records per second for LOGGER_DURATION_MS, flushing
+ * every flush_records records or every flush_ms milliseconds when not 0.
+ * Returns false when the logger fell behind.
+ */
+static bool run_logger(uint32_t rate, uint32_t flush_records, uint32_t flush_ms)
+{
+    AccessPattern sizes(AccessPattern::UNIFORM, LOGGER_RECORD_MAX_SIZE - LOGGER_RECORD_SIZE + 1);
+    LatencyHistogram append_latency;
+    LatencyHistogram flush_latency;
+    uint64_t log_size = 0;
+    uint64_t max_log_size = bd.size() / 100 * LOGGER_MAX_FILL_PERCENT;
+    uint32_t period_us = 1000000 / rate;
+    uint32_t max_lag_us = 0;
+    uint32_t behind_at = 0;
+    uint32_t seq = 0;
+
+    int res = !((fd = fopen(log_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    uint32_t start = us_ticker_read();
+    uint32_t last_flush = start;
+
+    while (true) {
+        uint32_t due = seq * period_us;
+        uint32_t now = us_ticker_read() - start;
+
+        // A logger that fell behind stops on time rather than after its last record
+        if (due >= LOGGER_DURATION_MS * 1000 || now >= LOGGER_DURATION_MS * 1000 || log_size >= max_log_size) {
+            break;
+        }
+
+        // Wait for the record to be due, a late record is written at once
+        if (now < due) {
+            wait_us(due - now);
+        } else if (now - due > max_lag_us) {
+            max_lag_us = now - due;
+            if (max_lag_us > LOGGER_MAX_LAG_MS * 1000 && !behind_at) {
+                behind_at = now;
+            }
+        }
+
+        size_t size = LOGGER_RECORD_SIZE + sizes.next();
+        fill_record(seq, size);
+
+        uint32_t write_start = us_ticker_read();
+        int write_sz = fwrite(record, sizeof(char), size, fd);
+        append_latency.record(us_ticker_read() - write_start);
+        TEST_ASSERT_EQUAL(size, write_sz);
+
+        log_size += size;
+        seq++;
+
+        bool flush = (flush_records && seq % flush_records == 0) ||
+                     (flush_ms && us_ticker_read() - last_flush >= flush_ms * 1000);
+        if (flush) {
+            last_flush = us_ticker_read();
+            res = flush_log();
+            flush_latency.record(us_ticker_read() - last_flush);
+            TEST_ASSERT_EQUAL(0, res);
+        }
+    }
+
+    uint32_t elapsed_us = us_ticker_read() - start;
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    printf("target %6lu rec/s: %9.1f rec/s, append p50 %6lu p99 %6lu us, flush p50 %7lu p99 %7lu max %7lu us (%lu flushes), max lag %7lu us",
+           (unsigned long)rate, seq * 1000000.0 / elapsed_us,
+           (unsigned long)append_latency.percentile(50), (unsigned long)append_latency.percentile(99),
+           (unsigned long)flush_latency.percentile(50), (unsigned long)flush_latency.percentile(99),
+           (unsigned long)flush_latency.max(), (unsigned long)flush_latency.count(),
+           (unsigned long)max_lag_us);
+    perf_report(seq * 1000000.0 / elapsed_us, "rate_%lu_rec_per_s", (unsigned long)rate);
+    perf_report(append_latency.percentile(99), "rate_%lu_append_p99_us", (unsigned long)rate);
+    perf_report(flush_latency.percentile(50), "rate_%lu_flush_p50_us", (unsigned long)rate);
+    perf_report(flush_latency.percentile(99), "rate_%lu_flush_p99_us", (unsigned long)rate);
+    perf_report(flush_latency.max(), "rate_%lu_flush_max_us", (unsigned long)rate);
+    perf_report(max_lag_us, "rate_%lu_max_lag_us", (unsigned long)rate);
+    if (behind_at) {
+        printf(", fell behind after %lu ms", (unsigned long)(behind_at / 1000));
+    }
+    if (log_size >= max_log_size) {
+        printf(", stopped at %llu B", (unsigned long long)log_size);
+    }
+    printf("\n");
+
+    res = remove(log_path);
+    TEST_ASSERT_EQUAL(0, res);
+
+    return !behind_at;
+}
+
+/*----------------logger------------------*/
+
+/* append records at increasing rates with the flush cadence, until the
+ * device can no longer keep up with the rate
+ */
+template <uint32_t flush_records, uint32_t flush_ms>
+void FS_logger()
+{
+    for (size_t i = 0; i < num_rates; i++) {
+        if (!run_logger(rates[i], flush_records, flush_ms)) {
+            printf("falls behind at %lu rec/s\n", (unsigned long)rates[i]);
+            return;
+        }
+    }
+    printf("keeps up with %lu rec/s\n", (unsigned long)rates[num_rates - 1]);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_logger_flush_on_close", FS_logger<0, 0>),
+    Case("FS_logger_flush_every_record", FS_logger<1, 0>),
+    Case("FS_logger_flush_every_16_records", FS_logger<16, 0>),
+    Case("FS_logger_flush_every_100_ms", FS_logger<0, 100>),
+    Case("FS_logger_flush_every_1000_ms", FS_logger<0, 1000>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    snprintf(log_path, sizeof(log_path), "/%s/log", test_fs_name());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
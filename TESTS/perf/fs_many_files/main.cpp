@@ -0,0 +1,280 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Bytes written to every file
+#ifndef MANY_FILES_FILE_SIZE
+#define MANY_FILES_FILE_SIZE 16
+#endif
+
+// Files in every directory of the nested layout
+#ifndef MANY_FILES_PER_DIR
+#define MANY_FILES_PER_DIR 10
+#endif
+
+static const size_t path_size = 48;
+
+// Operations timed for every file
+enum many_files_op_t {
+    OP_CREATE,
+    OP_OPEN,
+    OP_STAT,
+    OP_REMOVE,
+    OPS
+};
+
+static const char *const op_names[OPS] = {
+    "create", "open", "stat", "remove"
+};
+
+static LatencyHistogram op_latency[OPS];
+
+// Create latency by the number of files already created, 0-9, 10-99 and so on
+static const size_t decades = 5;
+static LatencyHistogram create_latency[decades];
+
+static uint8_t file_data[MANY_FILES_FILE_SIZE];
+
+/*----------------help functions------------------*/
+
+// Path of file i inside the mounted file system, as FileSystem calls take it
+static void file_path(char *path, bool nested, size_t i)
+{
+    if (nested) {
+        snprintf(path, path_size, "nested/dir_%05u/file_%05u", (unsigned)(i / MANY_FILES_PER_DIR), (unsigned)i);
+    } else {
+        snprintf(path, path_size, "flat/file_%05u", (unsigned)i);
+    }
+}
+
+// Same path with the mount point in front, as stdio calls take it
+static void full_path(char *path, bool nested, size_t i)
+{
+    char name[path_size];
+    file_path(name, nested, i);
+    snprintf(path, path_size, "/%s/%s", test_fs_name(), name);
+}
+
+static void dir_path(char *path, size_t dir)
+{
+    snprintf(path, path_size, "nested/dir_%05u", (unsigned)dir);
+}
+
+/* LittleFS takes a whole erase block for every file and a pair of blocks for
+ * every directory, FAT a cluster, which is assumed to be no smaller
+ */
+static bool fits(size_t num_files, bool nested)
+{
+    bd_size_t block = bd.get_erase_size() > 512 ? bd.get_erase_size() : 512;
+    bd_size_t needed = num_files * block;
+    if (nested) {
+        needed += 2 * block * (num_files / MANY_FILES_PER_DIR + 1);
+    }
+    return needed <= bd.size() / 2;
+}
+
+static size_t decade(size_t i)
+{
+    size_t d = 0;
+    for (size_t limit = 10; i >= limit && d < decades - 1; limit *= 10) {
+        d++;
+    }
+    return d;
+}
+
+static void print_latency()
+{
+    printf("%-8s %8s %10s %10s %10s %10s\n", "op", "count", "p50 us", "p90 us", "p99 us", "max us");
+    for (int op = 0; op < OPS; op++) {
+        printf("%-8s %8lu %10lu %10lu %10lu %10lu\n", op_names[op],
+               (unsigned long)op_latency[op].count(),
+               (unsigned long)op_latency[op].percentile(50),
+               (unsigned long)op_latency[op].percentile(90),
+               (unsigned long)op_latency[op].percentile(99),
+               (unsigned long)op_latency[op].max());
+        perf_report(op_latency[op].percentile(50), "%s_p50_us", op_names[op]);
+        perf_report(op_latency[op].percentile(90), "%s_p90_us", op_names[op]);
+        perf_report(op_latency[op].percentile(99), "%s_p99_us", op_names[op]);
+        perf_report(op_latency[op].max(), "%s_max_us", op_names[op]);
+    }
+
+    size_t first = 0;
+    for (size_t d = 0; d < decades && create_latency[d].count(); d++) {
+        printf("create with %5lu+ files: p50 %8lu us, max %8lu us\n", (unsigned long)first,
+               (unsigned long)create_latency[d].percentile(50), (unsigned long)create_latency[d].max());
+        perf_report(create_latency[d].percentile(50), "create_%lu_plus_p50_us", (unsigned long)first);
+        first = first ? first * 10 : 10;
+    }
+}
+
+/*----------------many files------------------*/
+
+/* create, open, stat and remove num_files files either in a single directory
+ * or spread over directories of MANY_FILES_PER_DIR files each
+ */
+template <size_t num_files, bool nested>
+void FS_many_files()
+{
+    char path[path_size];
+    struct stat st;
+
+    if (!fits(num_files, nested)) {
+        printf("SKIPPED: %lu files do not fit on this device\n", (unsigned long)num_files);
+        TEST_IGNORE_MESSAGE("files do not fit on this device");
+        return;
+    }
+
+    for (int op = 0; op < OPS; op++) {
+        op_latency[op].reset();
+    }
+    for (size_t d = 0; d < decades; d++) {
+        create_latency[d].reset();
+    }
+
+    int res = fs->mkdir(nested ? "nested" : "flat", 0777);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t i = 0; i < num_files; i++) {
+        if (nested && i % MANY_FILES_PER_DIR == 0) {
+            dir_path(path, i / MANY_FILES_PER_DIR);
+            res = fs->mkdir(path, 0777);
+            TEST_ASSERT_EQUAL(0, res);
+        }
+
+        full_path(path, nested, i);
+
+        uint32_t start = us_ticker_read();
+        FILE *file = fopen(path, "w");
+        TEST_ASSERT_NOT_NULL(file);
+        size_t write_sz = fwrite(file_data, sizeof(char), sizeof(file_data), file);
+        res = fclose(file);
+        uint32_t time_us = us_ticker_read() - start;
+        op_latency[OP_CREATE].record(time_us);
+        create_latency[decade(i)].record(time_us);
+
+        TEST_ASSERT_EQUAL(sizeof(file_data), write_sz);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    for (size_t i = 0; i < num_files; i++) {
+        full_path(path, nested, i);
+
+        uint32_t start = us_ticker_read();
+        FILE *file = fopen(path, "r");
+        TEST_ASSERT_NOT_NULL(file);
+        res = fclose(file);
+        op_latency[OP_OPEN].record(us_ticker_read() - start);
+
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    for (size_t i = 0; i < num_files; i++) {
+        file_path(path, nested, i);
+
+        uint32_t start = us_ticker_read();
+        res = fs->stat(path, &st);
+        op_latency[OP_STAT].record(us_ticker_read() - start);
+
+        TEST_ASSERT_EQUAL(0, res);
+        TEST_ASSERT_EQUAL(sizeof(file_data), st.st_size);
+    }
+
+    for (size_t i = 0; i < num_files; i++) {
+        file_path(path, nested, i);
+
+        uint32_t start = us_ticker_read();
+        res = fs->remove(path);
+        op_latency[OP_REMOVE].record(us_ticker_read() - start);
+
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    if (nested) {
+        for (size_t dir = 0; dir * MANY_FILES_PER_DIR < num_files; dir++) {
+            dir_path(path, dir);
+            res = fs->remove(path);
+            TEST_ASSERT_EQUAL(0, res);
+        }
+    }
+
+    res = fs->remove(nested ? "nested" : "flat");
+    TEST_ASSERT_EQUAL(0, res);
+
+    print_latency();
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_many_files_flat_10", FS_many_files<10, false>),
+    Case("FS_many_files_flat_100", FS_many_files<100, false>),
+    Case("FS_many_files_flat_1000", FS_many_files<1000, false>),
+    Case("FS_many_files_flat_10000", FS_many_files<10000, false>),
+
+    Case("FS_many_files_nested_10", FS_many_files<10, true>),
+    Case("FS_many_files_nested_100", FS_many_files<100, true>),
+    Case("FS_many_files_nested_1000", FS_many_files<1000, true>),
+    Case("FS_many_files_nested_10000", FS_many_files<10000, true>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(7200, "default_auto");
+
+    for (size_t i = 0; i < sizeof(file_data); i++) {
+        file_data[i] = i & 0xff;
+    }
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
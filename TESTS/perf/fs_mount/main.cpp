@@ -0,0 +1,262 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Times every format, mount and unmount is repeated
+#ifndef MOUNT_REPEATS
+#define MOUNT_REPEATS 10
+#endif
+
+// Bytes of every file the volume is filled with
+#ifndef MOUNT_FILE_SIZE
+#define MOUNT_FILE_SIZE 4096
+#endif
+
+// Files in every directory the volume is filled with
+#ifndef MOUNT_FILES_PER_DIR
+#define MOUNT_FILES_PER_DIR 100
+#endif
+
+// Rewrites of a single file before the mount is timed
+#ifndef MOUNT_REWRITES
+#define MOUNT_REWRITES 1000
+#endif
+
+static const size_t path_size = 32;
+
+static uint8_t file_data[MOUNT_FILE_SIZE];
+
+// Files the volume holds, the fill cases add to it
+static size_t num_files = 0;
+
+// Whether the selected file system is mounted, the format cases switch between them
+static bool mounted = false;
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+static void print_latency(const char *op, const LatencyHistogram &latency)
+{
+    printf("%-8s %4lu times: p50 %8lu us, max %8lu us\n", op, (unsigned long)latency.count(),
+           (unsigned long)latency.percentile(50), (unsigned long)latency.max());
+    perf_report(latency.percentile(50), "%s_p50_us", op);
+    perf_report(latency.max(), "%s_max_us", op);
+}
+
+/* Unmount and mount MOUNT_REPEATS times, deinitializing the block device in
+ * between as a cold boot would
+ */
+static void time_mount()
+{
+    LatencyHistogram mount_latency;
+    LatencyHistogram unmount_latency;
+
+    for (int i = 0; i < MOUNT_REPEATS; i++) {
+        Timer timer;
+        timer.start();
+        int res = fs->unmount();
+        timer.stop();
+        TEST_ASSERT_EQUAL(0, res);
+        unmount_latency.record(timer.read_us());
+
+        res = bd.deinit();
+        TEST_ASSERT_EQUAL(0, res);
+        res = bd.init();
+        TEST_ASSERT_EQUAL(0, res);
+
+        timer.reset();
+        timer.start();
+        res = fs->mount(&bd);
+        timer.stop();
+        TEST_ASSERT_EQUAL(0, res);
+        mount_latency.record(timer.read_us());
+    }
+
+    printf("%lu files of %lu B\n", (unsigned long)num_files, (unsigned long)MOUNT_FILE_SIZE);
+    print_latency("mount", mount_latency);
+    print_latency("unmount", unmount_latency);
+}
+
+/* Add files until they take fill_percent of the device, or the file system
+ * runs out of space
+ */
+static void fill(unsigned fill_percent)
+{
+    char path[path_size];
+    size_t target_files = bd.size() / 100 * fill_percent / MOUNT_FILE_SIZE;
+
+    for (; num_files < target_files; num_files++) {
+        if (num_files % MOUNT_FILES_PER_DIR == 0) {
+            snprintf(path, sizeof(path), "dir_%04u", (unsigned)(num_files / MOUNT_FILES_PER_DIR));
+            if (fs->mkdir(path, 0777)) {
+                break;
+            }
+        }
+
+        snprintf(path, sizeof(path), "/%s/dir_%04u/file_%04u", test_fs_name(),
+                 (unsigned)(num_files / MOUNT_FILES_PER_DIR), (unsigned)num_files);
+
+        fd = fopen(path, "w");
+        if (!fd) {
+            break;
+        }
+
+        size_t write_sz = fwrite(file_data, sizeof(char), sizeof(file_data), fd);
+        int res = fclose(fd);
+        if (write_sz != sizeof(file_data) || res) {
+            remove(path);
+            break;
+        }
+    }
+
+    if (num_files < target_files) {
+        printf("file system full after %lu files\n", (unsigned long)num_files);
+    }
+}
+
+/*----------------format------------------*/
+
+//format the device with a file system MOUNT_REPEATS times and leave it mounted and empty
+template <test_fs_t type>
+void FS_format()
+{
+    LatencyHistogram format_latency;
+
+    if (mounted) {
+        int res = fs->unmount();
+        TEST_ASSERT_EQUAL(0, res);
+        mounted = false;
+    }
+
+    test_fs_select(type);
+
+    for (int i = 0; i < MOUNT_REPEATS; i++) {
+        Timer timer;
+        timer.start();
+        int res = test_fs_format(&bd);
+        timer.stop();
+        TEST_ASSERT_EQUAL(0, res);
+        format_latency.record(timer.read_us());
+    }
+
+    print_latency("format", format_latency);
+
+    int res = fs->mount(&bd);
+    TEST_ASSERT_EQUAL(0, res);
+    mounted = true;
+    num_files = 0;
+}
+
+/*----------------mount------------------*/
+
+//fill the volume up to fill_percent of the device and time mount and unmount
+template <unsigned fill_percent>
+void FS_mount()
+{
+    fill(fill_percent);
+    time_mount();
+}
+
+/* rewrite a single file MOUNT_REWRITES times on a fresh volume and time mount
+ * and unmount, LittleFS keeps a revision of every metadata update
+ */
+void FS_mount_after_rewrites()
+{
+    char path[path_size];
+    snprintf(path, sizeof(path), "/%s/state", test_fs_name());
+
+    int res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = test_fs_format(&bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&bd);
+    TEST_ASSERT_EQUAL(0, res);
+    num_files = 0;
+
+    for (int i = 0; i < MOUNT_REWRITES; i++) {
+        res = !((fd = fopen(path, i ? "r+" : "w")) != NULL);
+        TEST_ASSERT_EQUAL(0, res);
+
+        int write_sz = fwrite(&i, sizeof(char), sizeof(i), fd);
+        TEST_ASSERT_EQUAL(sizeof(i), write_sz);
+
+        res = fclose(fd);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    printf("%d rewrites\n", MOUNT_REWRITES);
+    time_mount();
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FAT_format", FS_format<TEST_FS_FAT>),
+    Case("FAT_mount_empty", FS_mount<0>),
+    Case("FAT_mount_half_full", FS_mount<50>),
+    Case("FAT_mount_nearly_full", FS_mount<90>),
+    Case("FAT_mount_after_rewrites", FS_mount_after_rewrites),
+
+    Case("LFS_format", FS_format<TEST_FS_LFS>),
+    Case("LFS_mount_empty", FS_mount<0>),
+    Case("LFS_mount_half_full", FS_mount<50>),
+    Case("LFS_mount_nearly_full", FS_mount<90>),
+    Case("LFS_mount_after_rewrites", FS_mount_after_rewrites),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(14400, "default_auto");
+
+    for (size_t i = 0; i < sizeof(file_data); i++) {
+        file_data[i] = i & 0xff;
+    }
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    if (mounted) {
+        fs->unmount();
+    }
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
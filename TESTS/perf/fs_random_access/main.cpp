@@ -0,0 +1,199 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "AccessPattern.h"
+#include "PatternGenerator.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Bytes read after every seek, a multiple of 4
+#ifndef RANDOM_ACCESS_RECORD_SIZE
+#define RANDOM_ACCESS_RECORD_SIZE 64
+#endif
+
+// Seeks and reads done for every pattern
+#ifndef RANDOM_ACCESS_LOOKUPS
+#define RANDOM_ACCESS_LOOKUPS 1000
+#endif
+
+// Records skipped by every step of the strided pattern
+#ifndef RANDOM_ACCESS_STRIDE
+#define RANDOM_ACCESS_STRIDE 37
+#endif
+
+// Files bigger than this fraction (in percent) of the device are skipped
+#ifndef RANDOM_ACCESS_MAX_FILL_PERCENT
+#define RANDOM_ACCESS_MAX_FILL_PERCENT 50
+#endif
+
+static uint8_t record[RANDOM_ACCESS_RECORD_SIZE];
+static char bench_path[32];
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+// Every 4 byte word of a record holds the record index
+static void fill_record(uint32_t index)
+{
+    for (size_t i = 0; i < sizeof(record); i += 4) {
+        memcpy(&record[i], &index, 4);
+    }
+}
+
+static void create_file(uint32_t num_records)
+{
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (uint32_t i = 0; i < num_records; i++) {
+        fill_record(i);
+        int write_sz = fwrite(record, sizeof(char), sizeof(record), fd);
+        TEST_ASSERT_EQUAL(sizeof(record), write_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+// Seek to and read RANDOM_ACCESS_LOOKUPS records in the order of the pattern
+static void run_pattern(AccessPattern::type_t type, uint32_t num_records)
+{
+    AccessPattern pattern(type, num_records, RANDOM_ACCESS_STRIDE, PatternGenerator::run_seed());
+    LatencyHistogram seek_latency;
+    LatencyHistogram read_latency;
+
+    int res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (uint32_t i = 0; i < RANDOM_ACCESS_LOOKUPS; i++) {
+        uint32_t index = pattern.next();
+
+        uint32_t start = us_ticker_read();
+        res = fseek(fd, (long)index * sizeof(record), SEEK_SET);
+        uint32_t seeked = us_ticker_read();
+        int read_sz = fread(record, sizeof(char), sizeof(record), fd);
+        uint32_t end = us_ticker_read();
+
+        TEST_ASSERT_EQUAL(0, res);
+        TEST_ASSERT_EQUAL(sizeof(record), read_sz);
+
+        uint32_t stored;
+        memcpy(&stored, record, 4);
+        TEST_ASSERT_EQUAL(index, stored);
+
+        seek_latency.record(seeked - start);
+        read_latency.record(end - seeked);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    uint64_t total_us = seek_latency.total() + read_latency.total();
+    printf("%-10s %10.1f lookups/s, fseek p50 %6lu p99 %6lu max %6lu us, fread p50 %6lu p99 %6lu max %6lu us\n",
+           AccessPattern::name(type), total_us ? RANDOM_ACCESS_LOOKUPS * 1000000.0 / total_us : 0.0,
+           (unsigned long)seek_latency.percentile(50), (unsigned long)seek_latency.percentile(99),
+           (unsigned long)seek_latency.max(),
+           (unsigned long)read_latency.percentile(50), (unsigned long)read_latency.percentile(99),
+           (unsigned long)read_latency.max());
+
+    const char *name = AccessPattern::name(type);
+    perf_report(total_us ? RANDOM_ACCESS_LOOKUPS * 1000000.0 / total_us : 0.0, "%s_lookups_per_s", name);
+    perf_report(seek_latency.percentile(50), "%s_fseek_p50_us", name);
+    perf_report(seek_latency.percentile(99), "%s_fseek_p99_us", name);
+    perf_report(read_latency.percentile(50), "%s_fread_p50_us", name);
+    perf_report(read_latency.percentile(99), "%s_fread_p99_us", name);
+}
+
+/*----------------random access------------------*/
+
+//seek to and read records of a file of file_size bytes in every access pattern
+template <size_t file_size>
+void FS_random_access()
+{
+    if (file_size > bd.size() / 100 * RANDOM_ACCESS_MAX_FILL_PERCENT) {
+        printf("SKIPPED: file size %lu B is too large for this device\n", (unsigned long)file_size);
+        TEST_IGNORE_MESSAGE("file too large for this device");
+        return;
+    }
+
+    uint32_t num_records = file_size / RANDOM_ACCESS_RECORD_SIZE;
+    create_file(num_records);
+
+    for (int type = 0; type < AccessPattern::TYPES; type++) {
+        run_pattern((AccessPattern::type_t)type, num_records);
+    }
+
+    int res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_random_access_16KB", FS_random_access<16 * 1024>),
+    Case("FS_random_access_256KB", FS_random_access<256 * 1024>),
+    Case("FS_random_access_1MB", FS_random_access<1024 * 1024>),
+    Case("FS_random_access_4MB", FS_random_access<4 * 1024 * 1024>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/records", test_fs_name());
+
+    printf("access pattern seed %lu, build with -DTEST_SEED=%lu to repeat it\n",
+           (unsigned long)PatternGenerator::run_seed(), (unsigned long)PatternGenerator::run_seed());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
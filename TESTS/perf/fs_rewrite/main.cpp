@@ -0,0 +1,230 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "AccessPattern.h"
+#include "CountingBlockDevice.h"
+#include "LatencyHistogram.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Rewrites done for every record size and position
+#ifndef REWRITE_COUNT
+#define REWRITE_COUNT 20
+#endif
+
+// Largest record rewritten at once
+#ifndef REWRITE_MAX_RECORD_SIZE
+#define REWRITE_MAX_RECORD_SIZE 4096
+#endif
+
+// Files bigger than this fraction (in percent) of the device are skipped
+#ifndef REWRITE_MAX_FILL_PERCENT
+#define REWRITE_MAX_FILL_PERCENT 50
+#endif
+
+static const size_t record_sizes[] = {
+    16, 256, 4096
+};
+
+static const size_t num_record_sizes = sizeof(record_sizes) / sizeof(record_sizes[0]);
+
+// Where in the file the records are rewritten
+enum position_t {
+    POSITION_BEGINNING,
+    POSITION_MIDDLE,
+    POSITION_END,
+    POSITION_RANDOM,
+    POSITIONS
+};
+
+static const char *const position_names[POSITIONS] = {
+    "beginning", "middle", "end", "random"
+};
+
+static uint8_t record[REWRITE_MAX_RECORD_SIZE];
+static char bench_path[32];
+
+// Counts the bytes the rewrites program and erase
+CountingBlockDevice counting_bd(&bd);
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+static void create_file(size_t file_size)
+{
+    memset(record, 0xff, sizeof(record));
+
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t pos = 0; pos < file_size; pos += sizeof(record)) {
+        size_t size = file_size - pos < sizeof(record) ? file_size - pos : sizeof(record);
+        int write_sz = fwrite(record, sizeof(char), size, fd);
+        TEST_ASSERT_EQUAL(size, write_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/* Rewrite a record of record_size bytes REWRITE_COUNT times, opening and
+ * closing the file every time as state persistence code does
+ */
+static void rewrite_records(size_t file_size, size_t record_size, position_t position)
+{
+    uint32_t num_records = file_size / record_size;
+    AccessPattern random_records(AccessPattern::UNIFORM, num_records);
+    LatencyHistogram latency;
+    long offset = 0;
+
+    counting_bd.reset();
+
+    for (int i = 0; i < REWRITE_COUNT; i++) {
+        if (position == POSITION_MIDDLE) {
+            offset = num_records / 2 * record_size;
+        } else if (position == POSITION_END) {
+            offset = (num_records - 1) * record_size;
+        } else if (position == POSITION_RANDOM) {
+            offset = random_records.next() * record_size;
+        }
+        memset(record, i, record_size);
+
+        uint32_t start = us_ticker_read();
+
+        int res = !((fd = fopen(bench_path, "r+")) != NULL);
+        TEST_ASSERT_EQUAL(0, res);
+
+        res = fseek(fd, offset, SEEK_SET);
+        TEST_ASSERT_EQUAL(0, res);
+
+        int write_sz = fwrite(record, sizeof(char), record_size, fd);
+        TEST_ASSERT_EQUAL(record_size, write_sz);
+
+        res = fclose(fd);
+        TEST_ASSERT_EQUAL(0, res);
+
+        latency.record(us_ticker_read() - start);
+    }
+
+    double rewritten = (double)REWRITE_COUNT * record_size;
+    printf("file %8lu B record %5lu B at %-9s: p50 %8lu p99 %8lu max %8lu us, programmed %8.1f B/B, erased %8.1f B/B\n",
+           (unsigned long)file_size, (unsigned long)record_size, position_names[position],
+           (unsigned long)latency.percentile(50), (unsigned long)latency.percentile(99),
+           (unsigned long)latency.max(),
+           counting_bd.get_program_bytes() / rewritten, counting_bd.get_erase_bytes() / rewritten);
+
+    const char *name = position_names[position];
+    perf_report(latency.percentile(50), "record_%lu_%s_p50_us", (unsigned long)record_size, name);
+    perf_report(latency.percentile(99), "record_%lu_%s_p99_us", (unsigned long)record_size, name);
+    perf_report(counting_bd.get_program_bytes() / rewritten, "record_%lu_%s_programmed_per_byte", (unsigned long)record_size, name);
+    perf_report(counting_bd.get_erase_bytes() / rewritten, "record_%lu_%s_erased_per_byte", (unsigned long)record_size, name);
+
+    // The last record written must be in place
+    uint8_t read_buf[16];
+    int res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fseek(fd, offset, SEEK_SET);
+    TEST_ASSERT_EQUAL(0, res);
+
+    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd);
+    TEST_ASSERT_EQUAL(sizeof(read_buf), read_sz);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(record, read_buf, sizeof(read_buf));
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------rewrite------------------*/
+
+//rewrite records of every size at every position of a file of file_size bytes
+template <size_t file_size>
+void FS_rewrite()
+{
+    if (file_size > bd.size() / 100 * REWRITE_MAX_FILL_PERCENT) {
+        printf("SKIPPED: file size %lu B is too large for this device\n", (unsigned long)file_size);
+        TEST_IGNORE_MESSAGE("file too large for this device");
+        return;
+    }
+
+    create_file(file_size);
+
+    for (size_t i = 0; i < num_record_sizes; i++) {
+        if (record_sizes[i] > file_size || record_sizes[i] > REWRITE_MAX_RECORD_SIZE) {
+            continue;
+        }
+
+        for (int position = 0; position < POSITIONS; position++) {
+            rewrite_records(file_size, record_sizes[i], (position_t)position);
+        }
+    }
+
+    int res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_rewrite_4KB", FS_rewrite<4 * 1024>),
+    Case("FS_rewrite_64KB", FS_rewrite<64 * 1024>),
+    Case("FS_rewrite_1MB", FS_rewrite<1024 * 1024>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = counting_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/state", test_fs_name());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    counting_bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
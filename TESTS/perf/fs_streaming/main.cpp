@@ -0,0 +1,270 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "perf_report.h"
+#include "PatternGenerator.h"
+
+using namespace utest::v1;
+
+// Bytes passed to a single fwrite/fread call
+#ifndef STREAMING_CHUNK_SIZE
+#define STREAMING_CHUNK_SIZE 4096
+#endif
+
+// Number of parts of the file the throughput is printed for
+#ifndef STREAMING_SEGMENTS
+#define STREAMING_SEGMENTS 10
+#endif
+
+// Size of the file of the configurable case in percent of the device, 100 writes until the device is full
+#ifndef STREAMING_FILL_PERCENT
+#define STREAMING_FILL_PERCENT 90
+#endif
+
+#define STREAMING_STR(x) #x
+#define STREAMING_XSTR(x) STREAMING_STR(x)
+
+static uint8_t buffer[STREAMING_CHUNK_SIZE];
+static char bench_path[32];
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+/* Prints the throughput of the part of the stream since the last call, pos
+ * is where the stream is now
+ */
+class SegmentReport {
+public:
+    SegmentReport(const char *op) : _op(op), _pos(0), _time_us(0)
+    {
+        _timer.start();
+    }
+
+    void print(bd_size_t pos)
+    {
+        if (pos == _pos) {
+            return;
+        }
+
+        us_timestamp_t time_us = _timer.read_high_resolution_us();
+        double mb_per_s = (double)(pos - _pos) / (double)(time_us - _time_us);
+
+        printf("%-5s %10llu B (%3u%% of device) at %10llu us: %9.3f MB/s\n",
+               _op, (unsigned long long)pos, (unsigned)(pos * 100 / bd.size()),
+               (unsigned long long)time_us, mb_per_s);
+        perf_report(mb_per_s, "%s_at_%u_pct_mbps", _op, (unsigned)(pos * 100 / bd.size()));
+
+        _pos = pos;
+        _time_us = time_us;
+    }
+
+private:
+    const char *_op;
+    Timer _timer;
+    bd_size_t _pos;
+    us_timestamp_t _time_us;
+};
+
+// Bytes the file system has free, or the device size when it cannot tell
+static bd_size_t free_space()
+{
+    struct statvfs st;
+    if (fs->statvfs("", &st)) {
+        return bd.size();
+    }
+    return (bd_size_t)st.f_bavail * st.f_frsize;
+}
+
+/* Write file_size bytes of the seeded stream and return the bytes written,
+ * a short write ends the file. Only when until_full is set is the file
+ * expected to end early and fail to commit its last data.
+ */
+static bd_size_t stream_write(PatternGenerator &writer, bd_size_t file_size, bool until_full)
+{
+    bd_size_t segment_size = file_size / STREAMING_SEGMENTS;
+    bd_size_t next_report = segment_size;
+    bd_size_t pos = 0;
+
+    SegmentReport report("write");
+
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    while (pos < file_size) {
+        size_t size = file_size - pos < sizeof(buffer) ? file_size - pos : sizeof(buffer);
+        writer.fill(buffer, size);
+
+        size_t write_sz = fwrite(buffer, sizeof(char), size, fd);
+        pos += write_sz;
+
+        if (write_sz != size) {
+            printf("device full after %llu B\n", (unsigned long long)pos);
+            break;
+        }
+
+        if (pos >= next_report) {
+            report.print(pos);
+            next_report += segment_size;
+        }
+    }
+
+    // Data buffered when the device filled up may fail to commit
+    res = fclose(fd);
+    if (pos == file_size && !until_full) {
+        TEST_ASSERT_EQUAL(0, res);
+    }
+    report.print(pos);
+
+    return pos;
+}
+
+// Read the file back, check it against the seeded stream and return the bytes read
+static bd_size_t stream_read(PatternGenerator &reader, bd_size_t file_size)
+{
+    bd_size_t segment_size = file_size / STREAMING_SEGMENTS;
+    bd_size_t next_report = segment_size;
+    bd_size_t pos = 0;
+
+    SegmentReport report("read");
+
+    int res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    size_t read_sz;
+    while ((read_sz = fread(buffer, sizeof(char), sizeof(buffer), fd)) > 0) {
+        size_t mismatch = reader.check(buffer, read_sz);
+        if (mismatch != PatternGenerator::MATCH) {
+            printf("data differs at %llu B\n", (unsigned long long)(pos + mismatch));
+        }
+        TEST_ASSERT_EQUAL(PatternGenerator::MATCH, mismatch);
+        pos += read_sz;
+
+        if (pos >= next_report) {
+            report.print(pos);
+            next_report += segment_size;
+        }
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+    report.print(pos);
+
+    return pos;
+}
+
+/*----------------streaming------------------*/
+
+/* stream a file of fill_percent of the device and read it back, at 100
+ * percent the file is written until the file system runs out of space.
+ * Files larger than the free space of the file system are skipped.
+ */
+template <unsigned fill_percent>
+void FS_streaming()
+{
+    bool until_full = fill_percent >= 100;
+    bd_size_t file_size = until_full ? bd.size() : bd.size() / 100 * fill_percent;
+    PatternGenerator writer(PatternGenerator::run_seed());
+    PatternGenerator reader(PatternGenerator::run_seed());
+
+    if (!until_full && file_size > free_space()) {
+        printf("SKIPPED: file size %llu B is above the %llu B free on the file system\n",
+               (unsigned long long)file_size, (unsigned long long)free_space());
+        TEST_IGNORE_MESSAGE("file larger than the free space");
+        return;
+    }
+
+    bd_size_t written = stream_write(writer, file_size, until_full);
+
+    // The free space may not tell the metadata the file needs as it grows
+    if (!until_full && written < file_size) {
+        printf("SKIPPED: file system full after %llu of %llu B\n",
+               (unsigned long long)written, (unsigned long long)file_size);
+        remove(bench_path);
+        TEST_IGNORE_MESSAGE("file system full before the end of the file");
+        return;
+    }
+    bd_size_t read = stream_read(reader, written);
+
+    if (until_full) {
+        // Only the data committed before the file system filled up is expected back
+        TEST_ASSERT_TRUE(read <= written);
+        printf("%llu of %llu B read back\n", (unsigned long long)read, (unsigned long long)written);
+    } else {
+        TEST_ASSERT_TRUE(read == written);
+        TEST_ASSERT_EQUAL_HEX32(writer.crc(), reader.crc());
+        printf("CRC32 %08lx\n", (unsigned long)reader.crc());
+    }
+
+    int res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_streaming_25_percent", FS_streaming<25>),
+    Case("FS_streaming_50_percent", FS_streaming<50>),
+    Case("FS_streaming_75_percent", FS_streaming<75>),
+    Case("FS_streaming_" STREAMING_XSTR(STREAMING_FILL_PERCENT) "_percent", FS_streaming<STREAMING_FILL_PERCENT>),
+    Case("FS_streaming_until_full", FS_streaming<100>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(7200, "default_auto");
+
+    int res = bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/stream", test_fs_name());
+
+    printf("random data seed %lu, build with -DTEST_SEED=%lu to repeat it\n",
+           (unsigned long)PatternGenerator::run_seed(), (unsigned long)PatternGenerator::run_seed());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
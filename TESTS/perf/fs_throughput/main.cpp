@@ -0,0 +1,291 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "CountingBlockDevice.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Largest chunk passed to a single fwrite/fread call
+#ifndef THROUGHPUT_MAX_CHUNK_SIZE
+#define THROUGHPUT_MAX_CHUNK_SIZE (64 * 1024)
+#endif
+
+// Heap left free next to the chunk buffer, for the stdio buffer and the file state of fopen
+#ifndef THROUGHPUT_HEAP_RESERVE
+#define THROUGHPUT_HEAP_RESERVE (4 * 1024)
+#endif
+
+// Files bigger than this fraction (in percent) of the device are skipped
+#ifndef THROUGHPUT_MAX_FILL_PERCENT
+#define THROUGHPUT_MAX_FILL_PERCENT 50
+#endif
+
+// File written and read by the setvbuf cases, in records of SETVBUF_RECORD_SIZE bytes
+#ifndef SETVBUF_FILE_SIZE
+#define SETVBUF_FILE_SIZE (16 * 1024)
+#endif
+
+#ifndef SETVBUF_RECORD_SIZE
+#define SETVBUF_RECORD_SIZE 16
+#endif
+
+static const size_t chunk_sizes[] = {
+    1, 16, 64, 256, 1024, 4 * 1024, 16 * 1024, 64 * 1024
+};
+
+static const size_t num_chunk_sizes = sizeof(chunk_sizes) / sizeof(chunk_sizes[0]);
+
+static uint8_t *buffer = NULL;
+static size_t buffer_size = 0;
+static char bench_path[32];
+
+// Counts the programs and erases of the setvbuf cases
+CountingBlockDevice counting_bd(&bd);
+
+FILE *fd;
+
+/*----------------help functions------------------*/
+
+static void print_result(const char *op, size_t file_size, size_t chunk_size, us_timestamp_t time_us)
+{
+    double mb_per_s = (double)file_size / (double)time_us;
+    double ops_per_s = (double)(file_size / chunk_size) * 1000000.0 / (double)time_us;
+
+    printf("%-5s file %8lu B chunk %6lu B: %9.3f MB/s %12.1f ops/s\n",
+           op, (unsigned long)file_size, (unsigned long)chunk_size, mb_per_s, ops_per_s);
+    perf_report(mb_per_s, "%s_chunk_%lu_mbps", op, (unsigned long)chunk_size);
+    perf_report(ops_per_s, "%s_chunk_%lu_ops_per_s", op, (unsigned long)chunk_size);
+}
+
+static us_timestamp_t write_file(size_t file_size, size_t chunk_size)
+{
+    Timer timer;
+    timer.start();
+
+    int res = !((fd = fopen(bench_path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t written = 0; written < file_size; written += chunk_size) {
+        int write_sz = fwrite(buffer, sizeof(char), chunk_size, fd);
+        TEST_ASSERT_EQUAL(chunk_size, write_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    timer.stop();
+    return timer.read_high_resolution_us();
+}
+
+static us_timestamp_t read_file(size_t file_size, size_t chunk_size)
+{
+    Timer timer;
+    timer.start();
+
+    int res = !((fd = fopen(bench_path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (size_t read = 0; read < file_size; read += chunk_size) {
+        int read_sz = fread(buffer, sizeof(char), chunk_size, fd);
+        TEST_ASSERT_EQUAL(chunk_size, read_sz);
+    }
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    timer.stop();
+    return timer.read_high_resolution_us();
+}
+
+/* Write and read back the setvbuf file in records, with the stream buffering
+ * set to mode with a buffer of vbuf_size bytes. Every record holds a newline,
+ * as text log lines do, so line buffering flushes after every record.
+ */
+static void setvbuf_run(int mode, const char *mode_name, size_t vbuf_size)
+{
+    us_timestamp_t time_us[2];
+
+    counting_bd.reset();
+
+    for (int dir = 0; dir < 2; dir++) {
+        Timer timer;
+        timer.start();
+
+        int res = !((fd = fopen(bench_path, dir ? "r" : "w")) != NULL);
+        TEST_ASSERT_EQUAL(0, res);
+
+        res = setvbuf(fd, NULL, mode, vbuf_size);
+        TEST_ASSERT_EQUAL(0, res);
+
+        for (size_t pos = 0; pos < SETVBUF_FILE_SIZE; pos += SETVBUF_RECORD_SIZE) {
+            int sz = dir ? fread(buffer, sizeof(char), SETVBUF_RECORD_SIZE, fd)
+                     : fwrite(buffer, sizeof(char), SETVBUF_RECORD_SIZE, fd);
+            TEST_ASSERT_EQUAL(SETVBUF_RECORD_SIZE, sz);
+        }
+
+        res = fclose(fd);
+        TEST_ASSERT_EQUAL(0, res);
+
+        timer.stop();
+        time_us[dir] = timer.read_high_resolution_us();
+
+        if (!dir) {
+            printf("%-6s buffer %5lu B: write %9.3f MB/s %6llu programs %6llu erases",
+                   mode_name, (unsigned long)vbuf_size,
+                   (double)SETVBUF_FILE_SIZE / (double)time_us[0],
+                   (unsigned long long)counting_bd.get_program_count(),
+                   (unsigned long long)counting_bd.get_erase_count());
+            perf_report((double)SETVBUF_FILE_SIZE / (double)time_us[0], "%s_%lu_write_mbps", mode_name + 1, (unsigned long)vbuf_size);
+            perf_report(counting_bd.get_program_count(), "%s_%lu_program_count", mode_name + 1, (unsigned long)vbuf_size);
+            perf_report(counting_bd.get_erase_count(), "%s_%lu_erase_count", mode_name + 1, (unsigned long)vbuf_size);
+        }
+    }
+
+    printf(", read %9.3f MB/s\n", (double)SETVBUF_FILE_SIZE / (double)time_us[1]);
+    perf_report((double)SETVBUF_FILE_SIZE / (double)time_us[1], "%s_%lu_read_mbps", mode_name + 1, (unsigned long)vbuf_size);
+
+    int res = remove(bench_path);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+/*----------------throughput------------------*/
+
+//write and read back a file of file_size bytes for every chunk size
+template <size_t file_size>
+void FS_throughput()
+{
+    if (file_size > bd.size() / 100 * THROUGHPUT_MAX_FILL_PERCENT) {
+        printf("SKIPPED: file size %lu B is too large for this device\n", (unsigned long)file_size);
+        TEST_IGNORE_MESSAGE("file too large for this device");
+        return;
+    }
+
+    for (size_t i = 0; i < num_chunk_sizes; i++) {
+        size_t chunk_size = chunk_sizes[i];
+
+        if (chunk_size > file_size || chunk_size > buffer_size) {
+            continue;
+        }
+
+        print_result("write", file_size, chunk_size, write_file(file_size, chunk_size));
+        print_result("read", file_size, chunk_size, read_file(file_size, chunk_size));
+
+        int res = remove(bench_path);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+}
+
+/*----------------setvbuf------------------*/
+
+//write and read back records through an unbuffered stream
+void FS_setvbuf_unbuffered()
+{
+    setvbuf_run(_IONBF, "_IONBF", 0);
+}
+
+/* write and read back records with line and full buffering, for every power
+ * of two buffer size from 64 bytes up to the erase size
+ */
+template <int mode>
+void FS_setvbuf_buffered()
+{
+    for (size_t size = 64; size <= bd.get_erase_size(); size *= 2) {
+        setvbuf_run(mode, mode == _IOLBF ? "_IOLBF" : "_IOFBF", size);
+    }
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FS_throughput_1KB", FS_throughput<1024>),
+    Case("FS_throughput_16KB", FS_throughput<16 * 1024>),
+    Case("FS_throughput_128KB", FS_throughput<128 * 1024>),
+    Case("FS_throughput_1MB", FS_throughput<1024 * 1024>),
+    Case("FS_throughput_4MB", FS_throughput<4 * 1024 * 1024>),
+
+    Case("FS_setvbuf_unbuffered", FS_setvbuf_unbuffered),
+    Case("FS_setvbuf_line_buffered", FS_setvbuf_buffered<_IOLBF>),
+    Case("FS_setvbuf_fully_buffered", FS_setvbuf_buffered<_IOFBF>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = counting_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = test_fs_format(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    res = fs->mount(&counting_bd);
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    /* Use the largest chunk buffer that fits in the heap left by the mounted
+     * file system with THROUGHPUT_HEAP_RESERVE bytes to spare, bigger chunks
+     * are skipped
+     */
+    buffer_size = THROUGHPUT_MAX_CHUNK_SIZE;
+    while (buffer_size) {
+        void *probe = malloc(buffer_size + THROUGHPUT_HEAP_RESERVE);
+        free(probe);
+        if (probe && (buffer = (uint8_t *)malloc(buffer_size))) {
+            break;
+        }
+        buffer_size /= 2;
+    }
+
+    if (!buffer) {
+        return STATUS_ABORT;
+    }
+
+    printf("chunk buffer of %lu B\n", (unsigned long)buffer_size);
+
+    for (size_t i = 0; i < buffer_size; i++) {
+        buffer[i] = i & 0xff;
+    }
+
+    snprintf(bench_path, sizeof(bench_path), "/%s/bench", test_fs_name());
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    fs->unmount();
+    counting_bd.deinit();
+    free(buffer);
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
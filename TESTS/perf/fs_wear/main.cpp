@@ -0,0 +1,261 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "greentea-client/test_env.h"
+#include "unity/unity.h"
+#include "utest/utest.h"
+#include "test_storage.h"
+#include "WearBlockDevice.h"
+#include "perf_report.h"
+
+using namespace utest::v1;
+
+// Rewrites every workload does
+#ifndef WEAR_REWRITES
+#define WEAR_REWRITES 1000
+#endif
+
+// Files rewritten in turn by the rewrite_files workload, and their size
+#ifndef WEAR_FILES
+#define WEAR_FILES 8
+#endif
+#ifndef WEAR_FILE_SIZE
+#define WEAR_FILE_SIZE 1024
+#endif
+
+// Bins of the printed wear histogram
+#ifndef WEAR_HISTOGRAM_BINS
+#define WEAR_HISTOGRAM_BINS 8
+#endif
+
+// Most worn blocks printed
+#ifndef WEAR_HOT_BLOCKS
+#define WEAR_HOT_BLOCKS 5
+#endif
+
+static const size_t path_size = 32;
+
+// Counts the wear of every erase block under the file system
+WearBlockDevice wear_bd(&bd);
+
+FILE *fd;
+
+static uint8_t buffer[WEAR_FILE_SIZE];
+
+/*----------------workloads------------------*/
+
+static void file_path(char *path, int index)
+{
+    snprintf(path, path_size, "/%s/wear_%d", test_fs_name(), index);
+}
+
+/* rewrite the end of a small file over and over, as FS_fseek_rewrite_non_empty_file_end
+ * does once
+ */
+static void rewrite_file_end()
+{
+    char path[path_size];
+    char read_buf[15] = {};
+    file_path(path, 0);
+
+    int res = !((fd = fopen(path, "w")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    int write_sz = fwrite("12345678901234", sizeof(char), 15, fd);
+    TEST_ASSERT_EQUAL(15, write_sz);
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    for (int i = 0; i < WEAR_REWRITES; i++) {
+        res = !((fd = fopen(path, "r+")) != NULL);
+        TEST_ASSERT_EQUAL(0, res);
+
+        res = fseek(fd, 9, SEEK_SET);
+        TEST_ASSERT_EQUAL(0, res);
+
+        write_sz = fwrite(i % 2 ? "abcde" : "ABCDE", sizeof(char), 5, fd);
+        TEST_ASSERT_EQUAL(5, write_sz);
+
+        res = fclose(fd);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+
+    res = !((fd = fopen(path, "r")) != NULL);
+    TEST_ASSERT_EQUAL(0, res);
+
+    int read_sz = fread(read_buf, sizeof(char), sizeof(read_buf), fd);
+    TEST_ASSERT_EQUAL(15, read_sz);
+    TEST_ASSERT_EQUAL_STRING(WEAR_REWRITES % 2 ? "123456789ABCDE" : "123456789abcde", read_buf);
+
+    res = fclose(fd);
+    TEST_ASSERT_EQUAL(0, res);
+}
+
+//rewrite a few small files as a whole in turn, as a settings store does
+static void rewrite_files()
+{
+    char path[path_size];
+
+    for (int i = 0; i < WEAR_REWRITES; i++) {
+        file_path(path, i % WEAR_FILES);
+        memset(buffer, i, sizeof(buffer));
+
+        int res = !((fd = fopen(path, "w")) != NULL);
+        TEST_ASSERT_EQUAL(0, res);
+
+        int write_sz = fwrite(buffer, sizeof(char), sizeof(buffer), fd);
+        TEST_ASSERT_EQUAL(sizeof(buffer), write_sz);
+
+        res = fclose(fd);
+        TEST_ASSERT_EQUAL(0, res);
+    }
+}
+
+enum workload_id_t {
+    WORKLOAD_REWRITE_FILE_END,
+    WORKLOAD_REWRITE_FILES
+};
+
+static void (*const workloads[])() = {
+    rewrite_file_end,
+    rewrite_files,
+};
+
+/*----------------help functions------------------*/
+
+// Print how many counters fall in each of WEAR_HISTOGRAM_BINS equal ranges of wear
+static void print_histogram()
+{
+    uint32_t bins[WEAR_HISTOGRAM_BINS] = {};
+    uint32_t bin_width = wear_bd.get_max() / WEAR_HISTOGRAM_BINS + 1;
+
+    for (uint32_t i = 0; i < wear_bd.get_counters(); i++) {
+        bins[wear_bd.get_wear(i) / bin_width]++;
+    }
+
+    printf("wear              blocks\n");
+    for (int i = 0; i < WEAR_HISTOGRAM_BINS; i++) {
+        printf("%7lu - %7lu %8lu\n", (unsigned long)(i * bin_width),
+               (unsigned long)((i + 1) * bin_width - 1), (unsigned long)bins[i]);
+    }
+}
+
+/* Print the WEAR_HOT_BLOCKS most worn counters, each pass finds the most
+ * worn one ranked below the one found before
+ */
+static void print_hot_blocks()
+{
+    uint32_t prev = 0;
+    bool first = true;
+
+    printf("hot blocks:");
+    for (int n = 0; n < WEAR_HOT_BLOCKS; n++) {
+        bool found = false;
+        uint32_t hot = 0;
+
+        for (uint32_t i = 0; i < wear_bd.get_counters(); i++) {
+            uint32_t wear = wear_bd.get_wear(i);
+            bool below_prev = first || wear < wear_bd.get_wear(prev) ||
+                              (wear == wear_bd.get_wear(prev) && i > prev);
+            if (below_prev && (!found || wear > wear_bd.get_wear(hot))) {
+                hot = i;
+                found = true;
+            }
+        }
+
+        if (!found) {
+            break;
+        }
+        printf(" 0x%08llx (%lu)", (unsigned long long)(hot * wear_bd.get_counter_size()),
+               (unsigned long)wear_bd.get_wear(hot));
+        prev = hot;
+        first = false;
+    }
+    printf("\n");
+}
+
+/*----------------wear------------------*/
+
+/* run the workload on a freshly formatted file system and print how its
+ * erases spread over the erase blocks of the device
+ */
+template <test_fs_t type, workload_id_t id>
+void FS_wear()
+{
+    test_fs_select(type);
+
+    int res = test_fs_format(&wear_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    res = fs->mount(&wear_bd);
+    TEST_ASSERT_EQUAL(0, res);
+
+    // Only the wear of the workload counts, not the one of the format
+    wear_bd.reset();
+    workloads[id]();
+
+    res = fs->unmount();
+    TEST_ASSERT_EQUAL(0, res);
+
+    printf("%lu blocks of %llu B: max %lu, min %lu, mean %.2f, stddev %.2f\n",
+           (unsigned long)wear_bd.get_counters(), (unsigned long long)wear_bd.get_counter_size(),
+           (unsigned long)wear_bd.get_max(), (unsigned long)wear_bd.get_min(),
+           wear_bd.get_mean(), wear_bd.get_stddev());
+    print_histogram();
+    print_hot_blocks();
+
+    perf_report(wear_bd.get_max(), "wear_max_count");
+    perf_report(wear_bd.get_stddev(), "wear_stddev_count");
+    perf_report(wear_bd.get_min(), "wear_min_count");
+    perf_report(wear_bd.get_mean(), "wear_mean_count");
+}
+
+/*----------------setup------------------*/
+
+Case cases[] = {
+    Case("FAT_wear_rewrite_file_end", FS_wear<TEST_FS_FAT, WORKLOAD_REWRITE_FILE_END>),
+    Case("FAT_wear_rewrite_files", FS_wear<TEST_FS_FAT, WORKLOAD_REWRITE_FILES>),
+
+    Case("LFS_wear_rewrite_file_end", FS_wear<TEST_FS_LFS, WORKLOAD_REWRITE_FILE_END>),
+    Case("LFS_wear_rewrite_files", FS_wear<TEST_FS_LFS, WORKLOAD_REWRITE_FILES>),
+};
+
+utest::v1::status_t greentea_test_setup(const size_t number_of_cases)
+{
+    GREENTEA_SETUP(3600, "default_auto");
+
+    int res = wear_bd.init();
+    if (res) {
+        return STATUS_ABORT;
+    }
+
+    return greentea_test_setup_handler(number_of_cases);
+}
+
+void greentea_test_teardown(const size_t passed, const size_t failed, const failure_t failure)
+{
+    wear_bd.deinit();
+
+    greentea_test_teardown_handler(passed, failed, failure);
+}
+
+Specification specification(greentea_test_setup, cases, greentea_test_teardown, perf_report_handlers());
+
+int main()
+{
+    return !Harness::run(specification);
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+"""
+Copyright (c) 2017 ARM Limited
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Collect the {{perf;<bd>,<fs>,<case>,<metric>,<value>}} key-value pairs the
+tests send to the host from the output of 'mbed test --run -v', and store
+them keyed by target, block device, file system and commit.
+
+The JSON file is merged with the results already in it, as
+    {target: {bd: {fs: {commit: {case: {metric: value}}}}}}
+and the CSV file gets a row per metric appended, so both keep the history
+of every run they are given.
+"""
+
+import argparse
+import csv
+import json
+import os
+import re
+import subprocess
+import sys
+
+KV_PATTERN = re.compile(r'\{\{perf;([^}]*)\}\}')
+CSV_FIELDS = ['target', 'bd', 'fs', 'commit', 'case', 'metric', 'value']
+
+
+def current_commit():
+    try:
+        out = subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'],
+                                      stderr=subprocess.STDOUT)
+        return out.decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def parse(lines):
+    """Return {(bd, fs, case, metric): value}, a metric sent more than once
+    in a case keeps its last value"""
+    results = {}
+    for line in lines:
+        for match in KV_PATTERN.finditer(line):
+            fields = match.group(1).split(',')
+            if len(fields) != 5:
+                continue
+            try:
+                value = float(fields[4])
+            except ValueError:
+                continue
+            results[tuple(fields[:4])] = value
+    return results
+
+
+def write_json(path, target, commit, results):
+    data = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            data = json.load(f)
+
+    for (bd, fs, case, metric), value in results.items():
+        run = data.setdefault(target, {}).setdefault(bd, {}).setdefault(fs, {}).setdefault(commit, {})
+        run.setdefault(case, {})[metric] = value
+
+    with open(path, 'w') as f:
+        json.dump(data, f, indent=2, sort_keys=True)
+
+
+def write_csv(path, target, commit, results):
+    new_file = not os.path.exists(path)
+    with open(path, 'a') as f:
+        writer = csv.writer(f)
+        if new_file:
+            writer.writerow(CSV_FIELDS)
+        for (bd, fs, case, metric), value in sorted(results.items()):
+            writer.writerow([target, bd, fs, commit, case, metric, value])
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Collect perf results from mbed test output')
+    parser.add_argument('logs', nargs='*', help='test output files, standard input when none')
+    parser.add_argument('-m', '--target', required=True, help='target the tests ran on, e.g. K82F')
+    parser.add_argument('-c', '--commit', default=None, help='commit the tests were built from, HEAD by default')
+    parser.add_argument('--json', default=None, help='JSON file to merge the results into')
+    parser.add_argument('--csv', default=None, help='CSV file to append the results to')
+    args = parser.parse_args()
+
+    commit = args.commit or current_commit()
+
+    if args.logs:
+        results = {}
+        for log in args.logs:
+            with open(log) as f:
+                results.update(parse(f))
+    else:
+        results = parse(sys.stdin)
+
+    if not results:
+        print('no perf results found')
+        return 1
+
+    if args.json:
+        write_json(args.json, args.target, commit, results)
+    if args.csv:
+        write_csv(args.csv, args.target, commit, results)
+
+    print('%d metrics of %d cases collected for %s at %s' % (
+        len(results), len(set(key[:3] for key in results)), args.target, commit))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
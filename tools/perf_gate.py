@@ -0,0 +1,155 @@
+#!/usr/bin/env python
+"""
+Copyright (c) 2017 ARM Limited
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+Compare a run collected by perf_collect.py against a stored baseline of the
+same target, block device and file system, and fail when a metric got worse
+by more than the tolerance: throughput (_mbps, _per_s) that dropped, or
+latency and block device traffic (_us, _count, _bytes, _cycles, _per_byte)
+that rose. Other metrics are not compared. Compared metrics of the baseline
+that the run is missing fail as well, as does a run with nothing to compare.
+"""
+
+import argparse
+import json
+import re
+import sys
+
+HIGHER_IS_BETTER = ('_mbps', '_per_s')
+LOWER_IS_BETTER = ('_us', '_count', '_bytes', '_cycles', '_per_byte')
+
+
+def direction(metric):
+    """1 when higher is better, -1 when lower is better, 0 when not compared"""
+    if metric.endswith(HIGHER_IS_BETTER):
+        return 1
+    if metric.endswith(LOWER_IS_BETTER):
+        return -1
+    return 0
+
+
+def select_run(data, target, bd, fs, commit, what):
+    """Cases of a run, the only commit is taken when none is given"""
+    try:
+        commits = data[target][bd][fs]
+    except KeyError:
+        sys.exit('no %s results for %s/%s/%s' % (what, target, bd, fs))
+
+    if commit is None:
+        if len(commits) != 1:
+            sys.exit('%s has results of %d commits for %s/%s/%s, select one with --%s-commit' % (
+                what, len(commits), target, bd, fs, what))
+        commit = list(commits)[0]
+
+    if commit not in commits:
+        sys.exit('no %s results of commit %s for %s/%s/%s' % (what, commit, target, bd, fs))
+    return commit, commits[commit]
+
+
+def compare(run, baseline, tolerance, latency_floor, case_filter):
+    """Return rows of (case, metric, baseline, run, change in percent, regressed)"""
+    rows = []
+    for case in sorted(run):
+        if case not in baseline or not case_filter.search(case):
+            continue
+        for metric in sorted(run[case]):
+            sign = direction(metric)
+            if not sign or metric not in baseline[case]:
+                continue
+
+            old = baseline[case][metric]
+            new = run[case][metric]
+            # Latencies below the floor are timer noise rather than a trend
+            if metric.endswith('_us') and max(old, new) < latency_floor:
+                continue
+
+            if old == 0:
+                change = 0.0 if new == 0 else float('inf')
+            else:
+                change = 100.0 * (new - old) / old
+            rows.append((case, metric, old, new, change, sign * change < -tolerance))
+    return rows
+
+
+def missing(run, baseline, case_filter):
+    """Return (case, metric) of the compared baseline metrics the run lacks, metric is None for a whole case"""
+    lost = []
+    for case in sorted(baseline):
+        if not case_filter.search(case):
+            continue
+        if case not in run:
+            lost.append((case, None))
+            continue
+        for metric in sorted(baseline[case]):
+            if direction(metric) and metric not in run[case]:
+                lost.append((case, metric))
+    return lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Check perf results against a baseline')
+    parser.add_argument('results', help='JSON file written by perf_collect.py')
+    parser.add_argument('baseline', help='baseline JSON file written by perf_collect.py')
+    parser.add_argument('-m', '--target', required=True)
+    parser.add_argument('--bd', required=True, help='block device, e.g. spif')
+    parser.add_argument('--fs', required=True, help='file system, fat or lfs')
+    parser.add_argument('--results-commit', default=None)
+    parser.add_argument('--baseline-commit', default=None)
+    parser.add_argument('-t', '--tolerance', type=float, default=10.0,
+                        help='allowed change for the worse in percent, 10 by default')
+    parser.add_argument('--latency-floor', type=float, default=100.0,
+                        help='latencies below this many us are not compared, 100 by default')
+    parser.add_argument('--case', default='.', help='regular expression of the cases to compare')
+    parser.add_argument('-v', '--verbose', action='store_true', help='print every compared metric')
+    args = parser.parse_args()
+
+    with open(args.results) as f:
+        results = json.load(f)
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    run_commit, run = select_run(results, args.target, args.bd, args.fs, args.results_commit, 'results')
+    base_commit, base = select_run(baseline, args.target, args.bd, args.fs, args.baseline_commit, 'baseline')
+
+    rows = compare(run, base, args.tolerance, args.latency_floor, re.compile(args.case))
+    regressions = [row for row in rows if row[5]]
+    lost = missing(run, base, re.compile(args.case))
+
+    print('%s/%s/%s: %s against baseline %s, %d metrics compared, tolerance %.1f%%' % (
+        args.target, args.bd, args.fs, run_commit, base_commit, len(rows), args.tolerance))
+    for case, metric, old, new, change, regressed in (rows if args.verbose else regressions):
+        print('%-10s %-52s %-36s %12g -> %12g %+8.1f%%' % (
+            'REGRESSED' if regressed else 'ok', case, metric, old, new, change))
+    for case, metric in lost:
+        print('%-10s %-52s %s' % ('MISSING', case, metric or '(whole case)'))
+
+    failed = False
+    if regressions:
+        print('%d metrics regressed' % len(regressions))
+        failed = True
+    if lost:
+        print('%d baseline cases or metrics missing from the run' % len(lost))
+        failed = True
+    if not rows:
+        print('no metrics compared')
+        failed = True
+    if failed:
+        return 1
+    print('no regressions')
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,97 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "AccessPattern.h"
+#include "PatternGenerator.h"
+#include <math.h>
+
+static double zeta(uint32_t n, double theta)
+{
+    double sum = 0;
+    for (uint32_t i = 1; i <= n; i++) {
+        sum += 1.0 / pow((double)i, theta);
+    }
+    return sum;
+}
+
+AccessPattern::AccessPattern(type_t type, uint32_t num_records, uint32_t stride, uint32_t seed, double theta)
+    : _type(type), _num_records(num_records), _stride(stride), _state(seed ? seed : 1), _position(0),
+      _theta(theta), _zetan(0), _alpha(0), _eta(0)
+{
+    if (_type == ZIPFIAN) {
+        double zeta2 = zeta(2, _theta);
+        _zetan = zeta(_num_records, _theta);
+        _alpha = 1.0 / (1.0 - _theta);
+        _eta = (1.0 - pow(2.0 / _num_records, 1.0 - _theta)) / (1.0 - zeta2 / _zetan);
+    }
+}
+
+uint32_t AccessPattern::next()
+{
+    uint32_t index;
+
+    switch (_type) {
+        case SEQUENTIAL:
+            index = _position;
+            _position = (_position + 1) % _num_records;
+            return index;
+
+        case STRIDED:
+            index = _position;
+            _position = (uint32_t)(((uint64_t)_position + _stride) % _num_records);
+            return index;
+
+        case UNIFORM:
+            return random() % _num_records;
+
+        case ZIPFIAN: {
+            double u = random_unit();
+            double uz = u * _zetan;
+
+            if (uz < 1.0) {
+                index = 0;
+            } else if (uz < 1.0 + pow(0.5, _theta)) {
+                index = 1;
+            } else {
+                index = (uint32_t)(_num_records * pow(_eta * u - _eta + 1.0, _alpha));
+            }
+
+            // Scatter the hot records, Knuth's multiplicative hash
+            return (uint32_t)(((uint64_t)index * 2654435761u) % _num_records);
+        }
+
+        default:
+            return 0;
+    }
+}
+
+const char *AccessPattern::name(type_t type)
+{
+    static const char *const names[TYPES] = {
+        "sequential", "strided", "uniform", "zipfian"
+    };
+
+    return type < TYPES ? names[type] : "unknown";
+}
+
+uint32_t AccessPattern::random()
+{
+    return PatternGenerator::xorshift32(_state);
+}
+
+double AccessPattern::random_unit()
+{
+    return random() / 4294967296.0;
+}
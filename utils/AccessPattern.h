@@ -0,0 +1,88 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ACCESS_PATTERN_H
+#define ACCESS_PATTERN_H
+
+#include <stdint.h>
+
+/** Generator of record indexes for access pattern benchmarks
+ *
+ *  Produces an endless sequence of indexes below the number of records:
+ *  - SEQUENTIAL    0, 1, 2, ... wrapping at the end
+ *  - STRIDED       0, stride, 2 * stride, ... wrapping modulo the record count
+ *  - UNIFORM       uniformly random indexes
+ *  - ZIPFIAN       random indexes where a few records take most accesses,
+ *                  following Gray et al., "Quickly Generating Billion-Record
+ *                  Synthetic Databases". The hot records are scattered over
+ *                  the whole range rather than packed at its start.
+ *
+ *  The random patterns are reproducible for a given seed.
+ */
+class AccessPattern
+{
+public:
+    enum type_t {
+        SEQUENTIAL,
+        STRIDED,
+        UNIFORM,
+        ZIPFIAN,
+        TYPES
+    };
+
+    /** Lifetime of the generator
+     *
+     *  The Zipfian pattern computes its constants here, which takes time
+     *  linear in the number of records.
+     *
+     *  @param type         Pattern to generate
+     *  @param num_records  Number of records the indexes fall in
+     *  @param stride       Distance between indexes of the STRIDED pattern
+     *  @param seed         Seed of the random patterns, must not be 0
+     *  @param theta        Skew of the ZIPFIAN pattern, between 0 and 1
+     */
+    AccessPattern(type_t type, uint32_t num_records, uint32_t stride = 1,
+                  uint32_t seed = 1, double theta = 0.99);
+
+    /** Next record index
+     *
+     *  @return     Index below the number of records
+     */
+    uint32_t next();
+
+    /** Name of a pattern type
+     *
+     *  @param type Pattern type
+     *  @return     Lower case name of the pattern
+     */
+    static const char *name(type_t type);
+
+private:
+    uint32_t random();
+    double random_unit();
+
+    type_t _type;
+    uint32_t _num_records;
+    uint32_t _stride;
+    uint32_t _state;
+    uint32_t _position;
+
+    double _theta;
+    double _zetan;
+    double _alpha;
+    double _eta;
+};
+
+#endif
@@ -0,0 +1,163 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "CountingBlockDevice.h"
+
+CountingBlockDevice::CountingBlockDevice(BlockDevice *bd)
+    : _bd(bd)
+{
+    reset();
+}
+
+CountingBlockDevice::~CountingBlockDevice()
+{
+}
+
+int CountingBlockDevice::init()
+{
+    return _bd->init();
+}
+
+int CountingBlockDevice::deinit()
+{
+    return _bd->deinit();
+}
+
+int CountingBlockDevice::sync()
+{
+    _sync_count++;
+    uint32_t start = us_ticker_read();
+    int err = _bd->sync();
+    _busy_us += us_ticker_read() - start;
+    return err;
+}
+
+int CountingBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    _read_count++;
+    _read_bytes += size;
+    uint32_t start = us_ticker_read();
+    int err = _bd->read(buffer, addr, size);
+    _busy_us += us_ticker_read() - start;
+    return err;
+}
+
+int CountingBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    _program_count++;
+    _program_bytes += size;
+    uint32_t start = us_ticker_read();
+    int err = _bd->program(buffer, addr, size);
+    _busy_us += us_ticker_read() - start;
+    return err;
+}
+
+int CountingBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    _erase_count++;
+    _erase_bytes += size;
+    uint32_t start = us_ticker_read();
+    int err = _bd->erase(addr, size);
+    _busy_us += us_ticker_read() - start;
+    return err;
+}
+
+int CountingBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    return _bd->trim(addr, size);
+}
+
+bd_size_t CountingBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t CountingBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t CountingBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t CountingBlockDevice::get_erase_size(bd_addr_t addr) const
+{
+    return _bd->get_erase_size(addr);
+}
+
+int CountingBlockDevice::get_erase_value() const
+{
+    return _bd->get_erase_value();
+}
+
+bd_size_t CountingBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+void CountingBlockDevice::reset()
+{
+    _read_count = 0;
+    _read_bytes = 0;
+    _program_count = 0;
+    _program_bytes = 0;
+    _erase_count = 0;
+    _erase_bytes = 0;
+    _sync_count = 0;
+    _busy_us = 0;
+}
+
+bd_size_t CountingBlockDevice::get_read_count() const
+{
+    return _read_count;
+}
+
+bd_size_t CountingBlockDevice::get_read_bytes() const
+{
+    return _read_bytes;
+}
+
+bd_size_t CountingBlockDevice::get_program_count() const
+{
+    return _program_count;
+}
+
+bd_size_t CountingBlockDevice::get_program_bytes() const
+{
+    return _program_bytes;
+}
+
+bd_size_t CountingBlockDevice::get_erase_count() const
+{
+    return _erase_count;
+}
+
+bd_size_t CountingBlockDevice::get_erase_bytes() const
+{
+    return _erase_bytes;
+}
+
+bd_size_t CountingBlockDevice::get_sync_count() const
+{
+    return _sync_count;
+}
+
+uint64_t CountingBlockDevice::get_busy_us() const
+{
+    return _busy_us;
+}
@@ -0,0 +1,184 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COUNTING_BLOCK_DEVICE_H
+#define COUNTING_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+
+/** Block device for counting the operations of another block device
+ *
+ *  Every call is forwarded to the underlying block device, the number of
+ *  calls and the number of bytes they cover are counted until reset(), as
+ *  well as the time spent in the read, program, erase and sync calls.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "CountingBlockDevice.h"
+ *
+ *  HeapBlockDevice mem(512*512, 512);
+ *  CountingBlockDevice counter(&mem);
+ *
+ *  int main() {
+ *      counter.init();
+ *      counter.reset();
+ *
+ *      // do file system operations on counter
+ *
+ *      printf("%llu bytes programmed\n", counter.get_program_bytes());
+ *  }
+ *  @endcode
+ */
+class CountingBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the counting block device
+     *
+     *  @param bd   Block device to forward the operations to
+     */
+    CountingBlockDevice(BlockDevice *bd);
+    virtual ~CountingBlockDevice();
+
+    /** Initialize the underlying block device
+     *
+     *  @return     0 on success or a negative error code on failure
+     */
+    virtual int init();
+
+    /** Deinitialize the underlying block device
+     *
+     *  @return     0 on success or a negative error code on failure
+     */
+    virtual int deinit();
+
+    /** Ensure data on the underlying storage is in sync
+     *
+     *  @return     0 on success or a negative error code on failure
+     */
+    virtual int sync();
+
+    /** Read blocks from the underlying block device
+     *
+     *  @param buffer   Buffer to read blocks into
+     *  @param addr     Address of block to begin reading from
+     *  @param size     Size to read in bytes, must be a multiple of read block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Program blocks to the underlying block device
+     *
+     *  @param buffer   Buffer of data to write to blocks
+     *  @param addr     Address of block to begin writing to
+     *  @param size     Size to write in bytes, must be a multiple of program block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+
+    /** Erase blocks on the underlying block device
+     *
+     *  @param addr     Address of block to begin erasing
+     *  @param size     Size to erase in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+
+    /** Mark blocks as no longer in use on the underlying block device
+     *
+     *  @param addr     Address of block to mark as unused
+     *  @param size     Size to mark as unused in bytes, must be a multiple of erase block size
+     *  @return         0 on success, negative error code on failure
+     */
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+
+    /** Get the size of a readable block
+     *
+     *  @return         Size of a readable block in bytes
+     */
+    virtual bd_size_t get_read_size() const;
+
+    /** Get the size of a programmable block
+     *
+     *  @return         Size of a programmable block in bytes
+     */
+    virtual bd_size_t get_program_size() const;
+
+    /** Get the size of an erasable block
+     *
+     *  @return         Size of an erasable block in bytes
+     */
+    virtual bd_size_t get_erase_size() const;
+
+    /** Get the size of an erasable block given address
+     *
+     *  @param addr     Address within the erasable block
+     *  @return         Size of an erasable block in bytes
+     */
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const;
+
+    /** Get the value of storage when erased
+     *
+     *  @return         The value of storage when erased, or -1 if it can't be relied on
+     */
+    virtual int get_erase_value() const;
+
+    /** Get the total size of the underlying device
+     *
+     *  @return         Size of the underlying device in bytes
+     */
+    virtual bd_size_t size() const;
+
+    /** Reset all counters to zero
+     */
+    void reset();
+
+    /** Number of read calls since the last reset */
+    bd_size_t get_read_count() const;
+
+    /** Number of bytes read since the last reset */
+    bd_size_t get_read_bytes() const;
+
+    /** Number of program calls since the last reset */
+    bd_size_t get_program_count() const;
+
+    /** Number of bytes programmed since the last reset */
+    bd_size_t get_program_bytes() const;
+
+    /** Number of erase calls since the last reset */
+    bd_size_t get_erase_count() const;
+
+    /** Number of bytes erased since the last reset */
+    bd_size_t get_erase_bytes() const;
+
+    /** Number of sync calls since the last reset */
+    bd_size_t get_sync_count() const;
+
+    /** Microseconds spent in read, program, erase and sync calls since the last reset */
+    uint64_t get_busy_us() const;
+
+private:
+    BlockDevice *_bd;
+    bd_size_t _read_count;
+    bd_size_t _read_bytes;
+    bd_size_t _program_count;
+    bd_size_t _program_bytes;
+    bd_size_t _erase_count;
+    bd_size_t _erase_bytes;
+    bd_size_t _sync_count;
+    uint64_t _busy_us;
+};
+
+#endif
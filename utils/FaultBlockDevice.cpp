@@ -0,0 +1,138 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FaultBlockDevice.h"
+
+FaultBlockDevice::FaultBlockDevice(BlockDevice *bd)
+    : _bd(bd), _armed(false), _faulted(false), _limit(0), _count(0)
+{
+}
+
+FaultBlockDevice::~FaultBlockDevice()
+{
+}
+
+void FaultBlockDevice::set_fault_after(bd_size_t ops)
+{
+    _armed = true;
+    _faulted = false;
+    _limit = ops;
+    _count = 0;
+}
+
+void FaultBlockDevice::clear_fault()
+{
+    _armed = false;
+    _faulted = false;
+    _count = 0;
+}
+
+bool FaultBlockDevice::is_faulted() const
+{
+    return _faulted;
+}
+
+bd_size_t FaultBlockDevice::get_write_count() const
+{
+    return _count;
+}
+
+bool FaultBlockDevice::write_allowed()
+{
+    if (_faulted || (_armed && _count >= _limit)) {
+        _faulted = true;
+        return false;
+    }
+
+    _count++;
+    return true;
+}
+
+int FaultBlockDevice::init()
+{
+    return _bd->init();
+}
+
+int FaultBlockDevice::deinit()
+{
+    return _bd->deinit();
+}
+
+int FaultBlockDevice::sync()
+{
+    if (_faulted) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    return _bd->sync();
+}
+
+int FaultBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    return _bd->read(buffer, addr, size);
+}
+
+int FaultBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    if (!write_allowed()) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    return _bd->program(buffer, addr, size);
+}
+
+int FaultBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    if (!write_allowed()) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    return _bd->erase(addr, size);
+}
+
+int FaultBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    if (_faulted) {
+        return BD_ERROR_DEVICE_ERROR;
+    }
+    return _bd->trim(addr, size);
+}
+
+bd_size_t FaultBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t FaultBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t FaultBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t FaultBlockDevice::get_erase_size(bd_addr_t addr) const
+{
+    return _bd->get_erase_size(addr);
+}
+
+int FaultBlockDevice::get_erase_value() const
+{
+    return _bd->get_erase_value();
+}
+
+bd_size_t FaultBlockDevice::size() const
+{
+    return _bd->size();
+}
@@ -0,0 +1,96 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FAULT_BLOCK_DEVICE_H
+#define FAULT_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+
+/** Block device for simulating a power loss on another block device
+ *
+ *  Program and erase calls are forwarded to the underlying block device
+ *  until the configured number of them has been reached. From then on they
+ *  fail without touching the underlying block device, as if the power was
+ *  cut before the operation started, until clear_fault() is called. Reads
+ *  are always forwarded.
+ *
+ *  @code
+ *  HeapBlockDevice mem(128*512, 512);
+ *  FaultBlockDevice faulty(&mem);
+ *
+ *  faulty.set_fault_after(3);
+ *  // only the first three programs or erases of this write reach mem
+ *  fwrite(buffer, 1, sizeof(buffer), file);
+ *  faulty.clear_fault();
+ *  @endcode
+ */
+class FaultBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the fault injecting block device
+     *
+     *  @param bd   Block device to forward the operations to
+     */
+    FaultBlockDevice(BlockDevice *bd);
+    virtual ~FaultBlockDevice();
+
+    /** Fail every program and erase after the given number of them
+     *
+     *  @param ops  Number of program and erase calls that still succeed,
+     *              counted from this call
+     */
+    void set_fault_after(bd_size_t ops);
+
+    /** Stop failing operations, as if the power came back
+     */
+    void clear_fault();
+
+    /** Check whether an operation was dropped since the last set_fault_after()
+     *
+     *  @return     True if a program or erase was dropped
+     */
+    bool is_faulted() const;
+
+    /** Number of program and erase calls forwarded since the last
+     *  set_fault_after() or clear_fault()
+     */
+    bd_size_t get_write_count() const;
+
+    // BlockDevice interface, see BlockDevice.h
+    virtual int init();
+    virtual int deinit();
+    virtual int sync();
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+    virtual bd_size_t get_read_size() const;
+    virtual bd_size_t get_program_size() const;
+    virtual bd_size_t get_erase_size() const;
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const;
+    virtual int get_erase_value() const;
+    virtual bd_size_t size() const;
+
+private:
+    bool write_allowed();
+
+    BlockDevice *_bd;
+    bool _armed;
+    bool _faulted;
+    bd_size_t _limit;
+    bd_size_t _count;
+};
+
+#endif
@@ -0,0 +1,125 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LatencyHistogram.h"
+#include <string.h>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    memset(_counts, 0, sizeof(_counts));
+    _count = 0;
+    _max = 0;
+    _total = 0;
+}
+
+unsigned LatencyHistogram::bucket_index(uint32_t us)
+{
+    if (us < 2 * sub_buckets) {
+        return us;
+    }
+
+    if (us >> max_trackable_bits) {
+        return buckets - 1;
+    }
+
+    unsigned msb = 0;
+    while (us >> (msb + 1)) {
+        msb++;
+    }
+
+    unsigned shift = msb - sub_bucket_bits;
+    return 2 * sub_buckets + (shift - 1) * sub_buckets + ((us >> shift) - sub_buckets);
+}
+
+uint32_t LatencyHistogram::bucket_upper_bound(unsigned index)
+{
+    if (index < 2 * sub_buckets) {
+        return index;
+    }
+
+    unsigned shift = (index - 2 * sub_buckets) / sub_buckets + 1;
+    uint32_t lower = (uint32_t)((index - 2 * sub_buckets) % sub_buckets + sub_buckets) << shift;
+    return lower + ((uint32_t)1 << shift) - 1;
+}
+
+void LatencyHistogram::record(uint32_t us)
+{
+    _counts[bucket_index(us)]++;
+    _count++;
+    _total += us;
+    if (us > _max) {
+        _max = us;
+    }
+}
+
+void LatencyHistogram::add(const LatencyHistogram &other)
+{
+    for (unsigned i = 0; i < buckets; i++) {
+        _counts[i] += other._counts[i];
+    }
+    _count += other._count;
+    _total += other._total;
+    if (other._max > _max) {
+        _max = other._max;
+    }
+}
+
+uint32_t LatencyHistogram::count() const
+{
+    return _count;
+}
+
+uint32_t LatencyHistogram::max() const
+{
+    return _max;
+}
+
+uint64_t LatencyHistogram::total() const
+{
+    return _total;
+}
+
+uint32_t LatencyHistogram::percentile(unsigned percent) const
+{
+    if (!_count) {
+        return 0;
+    }
+
+    // Rank of the value, rounded up so that p100 is the last value
+    uint64_t rank = ((uint64_t)_count * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < buckets; i++) {
+        seen += _counts[i];
+        if (seen >= rank) {
+            if (i == buckets - 1) {
+                return _max;
+            }
+
+            uint32_t bound = bucket_upper_bound(i);
+            return bound < _max ? bound : _max;
+        }
+    }
+
+    return _max;
+}
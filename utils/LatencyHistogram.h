@@ -0,0 +1,84 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+
+/** Log-linear latency histogram in the style of HdrHistogram
+ *
+ *  Values below 2^(sub_bucket_bits + 1) microseconds are counted exactly,
+ *  larger values fall in one of 2^sub_bucket_bits buckets per power of two,
+ *  which keeps the relative error of the percentiles below 12.5%. Values
+ *  above max_trackable_us are counted in the last bucket, the exact maximum
+ *  is tracked separately.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    /** Clear all recorded values
+     */
+    void reset();
+
+    /** Record a single latency
+     *
+     *  @param us   Latency in microseconds
+     */
+    void record(uint32_t us);
+
+    /** Add all values recorded in another histogram
+     *
+     *  @param other    Histogram to merge into this one
+     */
+    void add(const LatencyHistogram &other);
+
+    /** Number of recorded values
+     */
+    uint32_t count() const;
+
+    /** Largest recorded value in microseconds
+     */
+    uint32_t max() const;
+
+    /** Sum of all recorded values in microseconds
+     */
+    uint64_t total() const;
+
+    /** Value below which the given percent of the recorded values fall
+     *
+     *  @param percent  Percentile between 0 and 100
+     *  @return         Upper bound of the bucket holding the percentile,
+     *                  capped by the maximum, in microseconds
+     */
+    uint32_t percentile(unsigned percent) const;
+
+private:
+    static const unsigned sub_bucket_bits = 3;
+    static const unsigned sub_buckets = 1 << sub_bucket_bits;
+    static const unsigned max_trackable_bits = 24;
+    static const unsigned buckets = 2 * sub_buckets + (max_trackable_bits - sub_bucket_bits - 1) * sub_buckets;
+
+    static unsigned bucket_index(uint32_t us);
+    static uint32_t bucket_upper_bound(unsigned index);
+
+    uint32_t _counts[buckets];
+    uint32_t _count;
+    uint32_t _max;
+    uint64_t _total;
+};
+
+#endif
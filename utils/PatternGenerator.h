@@ -0,0 +1,117 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PATTERN_GENERATOR_H
+#define PATTERN_GENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Seeded stream of pseudo random bytes with a rolling CRC32
+ *
+ *  The same seed always gives the same stream, however it is split into
+ *  calls, so data of any size can be written and verified with a buffer
+ *  of a single chunk. A writer fills its chunks from one generator, a
+ *  reader checks its chunks against a second generator with the same seed.
+ *
+ *  @code
+ *  PatternGenerator writer(seed);
+ *  PatternGenerator reader(seed);
+ *
+ *  writer.fill(buf, sizeof(buf));
+ *  fwrite(buf, 1, sizeof(buf), file);
+ *  ...
+ *  fread(buf, 1, sizeof(buf), file);
+ *  if (reader.check(buf, sizeof(buf)) != PatternGenerator::MATCH) {
+ *      printf("mismatch at %lu\n", reader.position());
+ *  }
+ *  @endcode
+ */
+class PatternGenerator
+{
+public:
+    static const size_t MATCH = (size_t)-1;
+
+    /** Lifetime of the generator
+     *
+     *  @param seed Seed of the stream, 0 is replaced by 1
+     */
+    PatternGenerator(uint32_t seed);
+
+    /** Restart the stream from its first byte
+     */
+    void reset();
+
+    /** Fill a buffer with the next bytes of the stream
+     *
+     *  @param buf  Buffer to fill
+     *  @param size Number of bytes
+     */
+    void fill(void *buf, size_t size);
+
+    /** Compare a buffer with the next bytes of the stream
+     *
+     *  The CRC is updated with the buffer, not the expected bytes.
+     *
+     *  @param buf  Buffer to compare
+     *  @param size Number of bytes
+     *  @return     MATCH, or the offset of the first byte that differs
+     */
+    size_t check(const void *buf, size_t size);
+
+    /** CRC32 of all the bytes filled or checked since the start of the stream
+     */
+    uint32_t crc() const;
+
+    /** Bytes filled or checked since the start of the stream
+     */
+    uint64_t position() const;
+
+    /** Seed of the stream
+     */
+    uint32_t seed() const;
+
+    /** Update a CRC32 (IEEE 802.3) with more data
+     *
+     *  @param crc  CRC of the data before, 0 for no data
+     *  @param buf  Data
+     *  @param size Number of bytes
+     *  @return     CRC of all the data
+     */
+    static uint32_t crc32(uint32_t crc, const void *buf, size_t size);
+
+    /** Advance a xorshift32 state, the same sequence on every target for a given seed
+     *
+     *  @param state State to advance, must not be 0
+     *  @return      The new state, the next random word
+     */
+    static uint32_t xorshift32(uint32_t &state);
+
+    /** Seed of the run, -DTEST_SEED=N or taken from the time of the first call, never 0
+     */
+    static uint32_t run_seed();
+
+private:
+    uint8_t next_byte();
+
+    uint32_t _seed;
+    uint32_t _state;
+    uint32_t _word;
+    unsigned _word_bytes;
+    uint32_t _crc;
+    uint64_t _position;
+};
+
+#endif
@@ -0,0 +1,177 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "SimFlashBlockDevice.h"
+#include <string.h>
+
+SimFlashBlockDevice::SimFlashBlockDevice(bd_size_t size, bd_size_t read_size, bd_size_t program_size,
+                                         bd_size_t erase_size, bd_size_t page_size,
+                                         const sim_flash_timing_t &timing, int erase_value)
+    : _size(size), _read_size(read_size), _program_size(program_size)
+    , _erase_size(erase_size), _page_size(page_size), _timing(timing)
+    , _erase_value(erase_value), _blocks(NULL)
+{
+    MBED_ASSERT(_size % _erase_size == 0);
+    MBED_ASSERT(_erase_size % _program_size == 0);
+}
+
+SimFlashBlockDevice::~SimFlashBlockDevice()
+{
+    if (_blocks) {
+        for (bd_size_t i = 0; i < _size / _erase_size; i++) {
+            delete[] _blocks[i];
+        }
+        delete[] _blocks;
+    }
+}
+
+// Wait for the time an operation takes on the part
+void SimFlashBlockDevice::busy(uint64_t ns)
+{
+    wait_us((int)(ns / 1000));
+}
+
+int SimFlashBlockDevice::init()
+{
+    if (!_blocks) {
+        _blocks = new uint8_t*[_size / _erase_size];
+        for (bd_size_t i = 0; i < _size / _erase_size; i++) {
+            _blocks[i] = NULL;
+        }
+    }
+
+    return BD_ERROR_OK;
+}
+
+// The contents are kept until the device is destroyed, as on a real part
+int SimFlashBlockDevice::deinit()
+{
+    return BD_ERROR_OK;
+}
+
+int SimFlashBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(is_valid_read(addr, size));
+    uint8_t *data = static_cast<uint8_t *>(buffer);
+
+    busy((uint64_t)_timing.read_us * 1000 + size * _timing.read_ns_per_byte);
+
+    while (size > 0) {
+        bd_addr_t hi = addr / _erase_size;
+        bd_addr_t lo = addr % _erase_size;
+        bd_size_t chunk = _erase_size - lo < size ? _erase_size - lo : size;
+
+        if (_blocks[hi]) {
+            memcpy(data, &_blocks[hi][lo], chunk);
+        } else {
+            memset(data, _erase_value < 0 ? 0 : _erase_value, chunk);
+        }
+
+        data += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return BD_ERROR_OK;
+}
+
+int SimFlashBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(is_valid_program(addr, size));
+    const uint8_t *data = static_cast<const uint8_t *>(buffer);
+
+    bd_size_t pages = (addr + size - 1) / _page_size - addr / _page_size + 1;
+    busy(pages * _timing.program_us * 1000 + size * _timing.program_ns_per_byte);
+
+    while (size > 0) {
+        bd_addr_t hi = addr / _erase_size;
+        bd_addr_t lo = addr % _erase_size;
+        bd_size_t chunk = _erase_size - lo < size ? _erase_size - lo : size;
+
+        if (!_blocks[hi]) {
+            _blocks[hi] = new uint8_t[_erase_size];
+            if (!_blocks[hi]) {
+                return BD_ERROR_DEVICE_ERROR;
+            }
+            memset(_blocks[hi], _erase_value < 0 ? 0 : _erase_value, _erase_size);
+        }
+
+        // NOR flash can only program bytes that were erased since the last program
+        if (_erase_value >= 0) {
+            for (bd_size_t i = 0; i < chunk; i++) {
+                if (_blocks[hi][lo + i] != (uint8_t)_erase_value) {
+                    return BD_ERROR_DEVICE_ERROR;
+                }
+            }
+        }
+
+        memcpy(&_blocks[hi][lo], data, chunk);
+
+        data += chunk;
+        addr += chunk;
+        size -= chunk;
+    }
+
+    return BD_ERROR_OK;
+}
+
+int SimFlashBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    MBED_ASSERT(_blocks != NULL);
+    MBED_ASSERT(is_valid_erase(addr, size));
+
+    for (bd_addr_t hi = addr / _erase_size; hi < (addr + size) / _erase_size; hi++) {
+        busy((uint64_t)_timing.erase_us * 1000);
+
+        if (_blocks[hi] && _erase_value >= 0) {
+            memset(_blocks[hi], _erase_value, _erase_size);
+        }
+    }
+
+    return BD_ERROR_OK;
+}
+
+bd_size_t SimFlashBlockDevice::get_read_size() const
+{
+    return _read_size;
+}
+
+bd_size_t SimFlashBlockDevice::get_program_size() const
+{
+    return _program_size;
+}
+
+bd_size_t SimFlashBlockDevice::get_erase_size() const
+{
+    return _erase_size;
+}
+
+bd_size_t SimFlashBlockDevice::get_erase_size(bd_addr_t addr) const
+{
+    return _erase_size;
+}
+
+int SimFlashBlockDevice::get_erase_value() const
+{
+    return _erase_value;
+}
+
+bd_size_t SimFlashBlockDevice::size() const
+{
+    return _size;
+}
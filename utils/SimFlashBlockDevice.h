@@ -0,0 +1,112 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIM_FLASH_BLOCK_DEVICE_H
+#define SIM_FLASH_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+
+/** Timing of a simulated flash part, every operation busy waits for the time
+ *  it takes on the part
+ */
+struct sim_flash_timing_t {
+    uint32_t read_us;               // command overhead of every read
+    uint32_t read_ns_per_byte;      // transfer time of every byte read
+    uint32_t program_us;            // time to program one page
+    uint32_t program_ns_per_byte;   // transfer time of every byte programmed
+    uint32_t erase_us;              // time to erase one erase block
+};
+
+/** RAM backed block device with the geometry and timing of a flash part
+ *
+ *  Unlike HeapBlockDevice the erase size can be larger than the program
+ *  size, and every read, program and erase waits for the time the part
+ *  would take, so the file systems see the same geometry and close to the
+ *  same latencies as on the part. Programs are split into pages, a program
+ *  that crosses a page boundary costs a page program time for every page
+ *  it touches.
+ *
+ *  With an erase value of 0 or more the device is NOR flash: a byte must be
+ *  erased before it is programmed again, and a program over bytes that are
+ *  not erased fails with BD_ERROR_DEVICE_ERROR. With an erase value of -1
+ *  the device behaves like an SD card, blocks can be programmed any time and
+ *  erase only costs its time.
+ *
+ *  Erase blocks are allocated on their first program and kept until the
+ *  device is destroyed, as in HeapBlockDevice, so the contents survive a
+ *  deinit and init as they do on the part.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "SimFlashBlockDevice.h"
+ *
+ *  // 128 KiB of NOR flash, 256 B pages and 4 KiB sectors
+ *  sim_flash_timing_t nor_timing = {20, 1000, 850, 1000, 40000};
+ *  SimFlashBlockDevice nor(32*4096, 1, 1, 4096, 256, nor_timing, 0xff);
+ *
+ *  int main() {
+ *      nor.init();
+ *      nor.erase(0, 4096);
+ *      nor.program("hello", 0, 6);
+ *      nor.deinit();
+ *  }
+ *  @endcode
+ */
+class SimFlashBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the simulated block device
+     *
+     *  @param size         Size of the device in bytes
+     *  @param read_size    Minimum read size in bytes
+     *  @param program_size Minimum program size in bytes
+     *  @param erase_size   Erase block size in bytes
+     *  @param page_size    Bytes programmed in one page program time
+     *  @param timing       Latencies of the operations
+     *  @param erase_value  Value of erased bytes, or -1 when the device needs
+     *                      no erase before program
+     */
+    SimFlashBlockDevice(bd_size_t size, bd_size_t read_size, bd_size_t program_size,
+                        bd_size_t erase_size, bd_size_t page_size,
+                        const sim_flash_timing_t &timing, int erase_value = 0xff);
+    virtual ~SimFlashBlockDevice();
+
+    // BlockDevice interface, see BlockDevice.h
+    virtual int init();
+    virtual int deinit();
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+    virtual bd_size_t get_read_size() const;
+    virtual bd_size_t get_program_size() const;
+    virtual bd_size_t get_erase_size() const;
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const;
+    virtual int get_erase_value() const;
+    virtual bd_size_t size() const;
+
+private:
+    void busy(uint64_t ns);
+
+    bd_size_t _size;
+    bd_size_t _read_size;
+    bd_size_t _program_size;
+    bd_size_t _erase_size;
+    bd_size_t _page_size;
+    sim_flash_timing_t _timing;
+    int _erase_value;
+    uint8_t **_blocks;
+};
+
+#endif
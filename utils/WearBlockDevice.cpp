@@ -0,0 +1,196 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WearBlockDevice.h"
+#include <math.h>
+
+WearBlockDevice::WearBlockDevice(BlockDevice *bd, uint32_t max_counters)
+    : _bd(bd), _max_counters(max_counters), _num_counters(0), _counter_size(0), _wear(NULL)
+{
+}
+
+WearBlockDevice::~WearBlockDevice()
+{
+    delete[] _wear;
+}
+
+int WearBlockDevice::init()
+{
+    int err = _bd->init();
+    if (err) {
+        return err;
+    }
+
+    if (!_wear) {
+        bd_size_t blocks = _bd->size() / _bd->get_erase_size();
+        bd_size_t blocks_per_counter = (blocks + _max_counters - 1) / _max_counters;
+
+        _counter_size = blocks_per_counter * _bd->get_erase_size();
+        _num_counters = (_bd->size() + _counter_size - 1) / _counter_size;
+        _wear = new uint32_t[_num_counters];
+        reset();
+    }
+
+    return BD_ERROR_OK;
+}
+
+int WearBlockDevice::deinit()
+{
+    return _bd->deinit();
+}
+
+int WearBlockDevice::sync()
+{
+    return _bd->sync();
+}
+
+// Add one to the wear of every counter the range touches
+void WearBlockDevice::count(bd_addr_t addr, bd_size_t size)
+{
+    if (!_wear || size == 0) {
+        return;
+    }
+
+    for (bd_addr_t i = addr / _counter_size; i <= (addr + size - 1) / _counter_size; i++) {
+        _wear[i]++;
+    }
+}
+
+int WearBlockDevice::read(void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    return _bd->read(buffer, addr, size);
+}
+
+int WearBlockDevice::program(const void *buffer, bd_addr_t addr, bd_size_t size)
+{
+    if (_bd->get_erase_value() < 0) {
+        count(addr, size);
+    }
+    return _bd->program(buffer, addr, size);
+}
+
+int WearBlockDevice::erase(bd_addr_t addr, bd_size_t size)
+{
+    if (_bd->get_erase_value() >= 0) {
+        count(addr, size);
+    }
+    return _bd->erase(addr, size);
+}
+
+int WearBlockDevice::trim(bd_addr_t addr, bd_size_t size)
+{
+    return _bd->trim(addr, size);
+}
+
+bd_size_t WearBlockDevice::get_read_size() const
+{
+    return _bd->get_read_size();
+}
+
+bd_size_t WearBlockDevice::get_program_size() const
+{
+    return _bd->get_program_size();
+}
+
+bd_size_t WearBlockDevice::get_erase_size() const
+{
+    return _bd->get_erase_size();
+}
+
+bd_size_t WearBlockDevice::get_erase_size(bd_addr_t addr) const
+{
+    return _bd->get_erase_size(addr);
+}
+
+int WearBlockDevice::get_erase_value() const
+{
+    return _bd->get_erase_value();
+}
+
+bd_size_t WearBlockDevice::size() const
+{
+    return _bd->size();
+}
+
+void WearBlockDevice::reset()
+{
+    for (uint32_t i = 0; i < _num_counters; i++) {
+        _wear[i] = 0;
+    }
+}
+
+uint32_t WearBlockDevice::get_counters() const
+{
+    return _num_counters;
+}
+
+bd_size_t WearBlockDevice::get_counter_size() const
+{
+    return _counter_size;
+}
+
+uint32_t WearBlockDevice::get_wear(uint32_t index) const
+{
+    return _wear[index];
+}
+
+uint32_t WearBlockDevice::get_max() const
+{
+    uint32_t max = 0;
+    for (uint32_t i = 0; i < _num_counters; i++) {
+        if (_wear[i] > max) {
+            max = _wear[i];
+        }
+    }
+    return max;
+}
+
+uint32_t WearBlockDevice::get_min() const
+{
+    uint32_t min = _num_counters ? _wear[0] : 0;
+    for (uint32_t i = 1; i < _num_counters; i++) {
+        if (_wear[i] < min) {
+            min = _wear[i];
+        }
+    }
+    return min;
+}
+
+double WearBlockDevice::get_mean() const
+{
+    if (!_num_counters) {
+        return 0;
+    }
+
+    double sum = 0;
+    for (uint32_t i = 0; i < _num_counters; i++) {
+        sum += _wear[i];
+    }
+    return sum / _num_counters;
+}
+
+double WearBlockDevice::get_stddev() const
+{
+    if (!_num_counters) {
+        return 0;
+    }
+
+    double mean = get_mean();
+    double sum = 0;
+    for (uint32_t i = 0; i < _num_counters; i++) {
+        sum += (_wear[i] - mean) * (_wear[i] - mean);
+    }
+    return sqrt(sum / _num_counters);
+}
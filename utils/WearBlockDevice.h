@@ -0,0 +1,122 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WEAR_BLOCK_DEVICE_H
+#define WEAR_BLOCK_DEVICE_H
+
+#include "BlockDevice.h"
+
+/** Block device for counting the wear of every erase block of another block
+ *  device
+ *
+ *  Every call is forwarded to the underlying block device. Every erase adds
+ *  one to the count of each erase block it covers. A device that needs no
+ *  erase before program, get_erase_value() of -1 as on SD cards, wears on
+ *  programs instead, so there every program adds one to the count of each
+ *  erase block it touches.
+ *
+ *  To keep the counters in RAM on large devices at most max_counters are
+ *  kept, neighbouring erase blocks share a counter when the device has more
+ *  erase blocks than that.
+ *
+ *  @code
+ *  #include "mbed.h"
+ *  #include "HeapBlockDevice.h"
+ *  #include "WearBlockDevice.h"
+ *
+ *  HeapBlockDevice mem(512*512, 512);
+ *  WearBlockDevice wear(&mem);
+ *
+ *  int main() {
+ *      wear.init();
+ *
+ *      // do file system operations on wear
+ *
+ *      printf("most worn block erased %lu times\n", wear.get_max());
+ *  }
+ *  @endcode
+ */
+class WearBlockDevice : public BlockDevice
+{
+public:
+    /** Lifetime of the wear counting block device
+     *
+     *  @param bd           Block device to forward the operations to
+     *  @param max_counters Largest number of counters kept
+     */
+    WearBlockDevice(BlockDevice *bd, uint32_t max_counters = 4096);
+    virtual ~WearBlockDevice();
+
+    // BlockDevice interface, see BlockDevice.h
+    virtual int init();
+    virtual int deinit();
+    virtual int sync();
+    virtual int read(void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int program(const void *buffer, bd_addr_t addr, bd_size_t size);
+    virtual int erase(bd_addr_t addr, bd_size_t size);
+    virtual int trim(bd_addr_t addr, bd_size_t size);
+    virtual bd_size_t get_read_size() const;
+    virtual bd_size_t get_program_size() const;
+    virtual bd_size_t get_erase_size() const;
+    virtual bd_size_t get_erase_size(bd_addr_t addr) const;
+    virtual int get_erase_value() const;
+    virtual bd_size_t size() const;
+
+    /** Reset all counters to zero
+     *
+     *  The counters start at zero and are kept across deinit and init, as
+     *  format, mount and unmount deinit and init the device, so only this
+     *  call resets them.
+     */
+    void reset();
+
+    /** Number of counters, valid after init
+     */
+    uint32_t get_counters() const;
+
+    /** Bytes of the device covered by one counter
+     */
+    bd_size_t get_counter_size() const;
+
+    /** Wear of the erase blocks covered by a counter
+     *
+     *  @param index    Counter index, the counter covers the addresses from
+     *                  index * get_counter_size()
+     */
+    uint32_t get_wear(uint32_t index) const;
+
+    /** Highest wear of all counters */
+    uint32_t get_max() const;
+
+    /** Lowest wear of all counters */
+    uint32_t get_min() const;
+
+    /** Average wear of the counters */
+    double get_mean() const;
+
+    /** Standard deviation of the wear of the counters */
+    double get_stddev() const;
+
+private:
+    void count(bd_addr_t addr, bd_size_t size);
+
+    BlockDevice *_bd;
+    uint32_t _max_counters;
+    uint32_t _num_counters;
+    bd_size_t _counter_size;
+    uint32_t *_wear;
+};
+
+#endif
@@ -0,0 +1,123 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "mbed_stats.h"
+#include "memory_stats.h"
+#include "perf_report.h"
+
+// Threads looked through for the stack of the calling thread
+static const size_t max_threads = 16;
+
+static mbed_stats_heap_t case_start;
+static mbed_stats_heap_t case_end;
+static bool case_ended = false;
+
+// Heap at the end of the case, or now while the case runs
+static void case_heap(mbed_stats_heap_t *heap)
+{
+    if (case_ended) {
+        *heap = case_end;
+    } else {
+        mbed_stats_heap_get(heap);
+    }
+}
+
+void memory_stats_warm_up()
+{
+    char buf[16];
+
+    // Formatting a double allocates the conversion buffers of the thread
+    snprintf(buf, sizeof(buf), "%.1f", 1.5);
+
+    // Opening a stream allocates a block of FILE structures, even when the open fails
+    FILE *file = fopen("/memory_stats/warm_up", "r");
+    if (file) {
+        fclose(file);
+    }
+}
+
+void memory_stats_case_start()
+{
+    mbed_stats_heap_get(&case_start);
+    case_ended = false;
+}
+
+void memory_stats_case_end()
+{
+    mbed_stats_heap_get(&case_end);
+    case_ended = true;
+}
+
+int32_t memory_stats_case_leak()
+{
+    mbed_stats_heap_t heap;
+    case_heap(&heap);
+    return (int32_t)(heap.current_size - case_start.current_size);
+}
+
+uint32_t memory_stats_case_allocs()
+{
+    mbed_stats_heap_t heap;
+    case_heap(&heap);
+    return heap.alloc_cnt - case_start.alloc_cnt;
+}
+
+uint32_t memory_stats_heap_peak()
+{
+    mbed_stats_heap_t heap;
+    mbed_stats_heap_get(&heap);
+    return heap.max_size;
+}
+
+uint32_t memory_stats_stack_peak()
+{
+    mbed_stats_stack_t stacks[max_threads];
+    size_t count = mbed_stats_stack_get_each(stacks, max_threads);
+    uint32_t id = (uint32_t)(uintptr_t)osThreadGetId();
+
+    for (size_t i = 0; i < count; i++) {
+        if (stacks[i].thread_id == id) {
+            return stacks[i].max_size;
+        }
+    }
+    return 0;
+}
+
+void memory_stats_print_case()
+{
+    printf("%-14s %8s\n", "memory", "bytes");
+    printf("%-14s %8ld\n", "heap leaked", (long)memory_stats_case_leak());
+    printf("%-14s %8lu\n", "heap allocs", (unsigned long)memory_stats_case_allocs());
+}
+
+void memory_stats_report_case()
+{
+    perf_report(memory_stats_case_leak(), "heap_leak_bytes");
+    perf_report(memory_stats_case_allocs(), "heap_alloc_count");
+}
+
+void memory_stats_print_run()
+{
+    printf("%-22s %8s\n", "memory since boot", "bytes");
+    printf("%-22s %8lu\n", "heap peak", (unsigned long)memory_stats_heap_peak());
+    printf("%-22s %8lu\n", "stack peak", (unsigned long)memory_stats_stack_peak());
+}
+
+void memory_stats_report_run()
+{
+    perf_report(memory_stats_heap_peak(), "heap_peak_since_boot_bytes");
+    perf_report(memory_stats_stack_peak(), "stack_peak_since_boot_bytes");
+}
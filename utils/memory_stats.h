@@ -0,0 +1,67 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <stdint.h>
+
+/* Heap and stack use of a test case, from the mbed heap and stack stats.
+ * They need MBED_HEAP_STATS_ENABLED and MBED_STACK_STATS_ENABLED, which
+ * mbed_app.json sets, without them every value is 0.
+ *
+ * The leak and the allocations of a case are taken between two snapshots,
+ * after the block device and the file system are up and before they are
+ * taken down, so the memory they hold is not counted against the case.
+ *
+ * The heap and stack high-water marks of Mbed OS cannot be reset, so the
+ * peaks are the highest use since boot. A case that needs more memory than
+ * any case before it raises them, so they are only reported once per run.
+ */
+
+// Allocate what the C library allocates once on first use, so it is not taken for a leak
+void memory_stats_warm_up();
+
+// Take the heap in use and the allocation count at the start of a case
+void memory_stats_case_start();
+
+// Take the heap in use and the allocation count at the end of a case
+void memory_stats_case_end();
+
+// Bytes allocated since the start of the case and not freed by its end, or by now while it runs
+int32_t memory_stats_case_leak();
+
+// Allocations made since the start of the case until its end, or until now while it runs
+uint32_t memory_stats_case_allocs();
+
+// Highest heap use since boot in bytes
+uint32_t memory_stats_heap_peak();
+
+// Highest stack use of the calling thread since it started, in bytes
+uint32_t memory_stats_stack_peak();
+
+// Print the heap use of the current case
+void memory_stats_print_case();
+
+// Send the heap use of the current case to the host
+void memory_stats_report_case();
+
+// Print the heap and stack peaks since boot, at the end of a run
+void memory_stats_print_run();
+
+// Send the heap and stack peaks since boot to the host, at the end of a run
+void memory_stats_report_run();
+
+#endif
@@ -0,0 +1,60 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "perf_report.h"
+#include "test_storage.h"
+#include "greentea-client/test_env.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+using namespace utest::v1;
+
+static const size_t metric_size = 64;
+static const size_t value_size = 160;
+
+static const char *case_name = "none";
+
+static status_t perf_case_setup_handler(const Case *const source, const size_t index_of_case)
+{
+    perf_report_case(source->get_description());
+    return greentea_case_setup_handler(source, index_of_case);
+}
+
+handlers_t perf_report_handlers()
+{
+    handlers_t handlers = default_handlers;
+    handlers.case_setup = perf_case_setup_handler;
+    return handlers;
+}
+
+void perf_report_case(const char *name)
+{
+    case_name = name;
+}
+
+void perf_report(double value, const char *metric, ...)
+{
+    char name[metric_size];
+    char kv_value[value_size];
+
+    va_list args;
+    va_start(args, metric);
+    vsnprintf(name, sizeof(name), metric, args);
+    va_end(args);
+
+    snprintf(kv_value, sizeof(kv_value), "%s,%s,%s,%s,%.6g",
+             test_bd_name(), test_fs_name(), case_name, name, value);
+    greentea_send_kv("perf", kv_value);
+}
@@ -0,0 +1,46 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PERF_REPORT_H
+#define PERF_REPORT_H
+
+#include "utest/utest.h"
+
+/* Machine readable results. Every metric is sent to the host as a greentea
+ * key-value pair
+ *
+ *     {{perf;<bd>,<fs>,<case>,<metric>,<value>}}
+ *
+ * next to the human readable output, for tools/perf_collect.py to gather.
+ * Metric names end in their unit: _us, _count, _bytes, _cycles and
+ * _per_byte are better when lower, _mbps and _per_s are better when higher.
+ */
+
+/* Default handlers of a Specification that take the case name for the
+ * metrics from every case, with the greentea handlers otherwise
+ */
+utest::v1::handlers_t perf_report_handlers();
+
+// Set the case name sent with the metrics
+void perf_report_case(const char *name);
+
+/** Send a metric of the current case to the host
+ *
+ *  @param value    Value of the metric
+ *  @param metric   printf style format of the metric name
+ */
+void perf_report(double value, const char *metric, ...);
+
+#endif
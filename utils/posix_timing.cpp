@@ -0,0 +1,153 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mbed.h"
+#include "posix_timing.h"
+#include "perf_report.h"
+
+static const char *const op_names[TIMING_OPS] = {
+    "fopen", "fwrite", "fread", "fseek", "fflush", "fclose"
+};
+
+static LatencyHistogram case_hist[TIMING_OPS];
+static LatencyHistogram total_hist[TIMING_OPS];
+static uint64_t case_bytes[TIMING_OPS];
+
+static void record(posix_timing_op_t op, uint32_t start)
+{
+    uint32_t us = us_ticker_read() - start;
+    case_hist[op].record(us);
+    total_hist[op].record(us);
+}
+
+FILE *timed_fopen(const char *path, const char *mode)
+{
+    uint32_t start = us_ticker_read();
+    FILE *file = fopen(path, mode);
+    record(TIMING_FOPEN, start);
+    return file;
+}
+
+size_t timed_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    uint32_t start = us_ticker_read();
+    size_t res = fwrite(ptr, size, nmemb, stream);
+    record(TIMING_FWRITE, start);
+    case_bytes[TIMING_FWRITE] += res * size;
+    return res;
+}
+
+size_t timed_fread(void *ptr, size_t size, size_t nmemb, FILE *stream)
+{
+    uint32_t start = us_ticker_read();
+    size_t res = fread(ptr, size, nmemb, stream);
+    record(TIMING_FREAD, start);
+    case_bytes[TIMING_FREAD] += res * size;
+    return res;
+}
+
+int timed_fseek(FILE *stream, long offset, int whence)
+{
+    uint32_t start = us_ticker_read();
+    int res = fseek(stream, offset, whence);
+    record(TIMING_FSEEK, start);
+    return res;
+}
+
+int timed_fflush(FILE *stream)
+{
+    uint32_t start = us_ticker_read();
+    int res = fflush(stream);
+    record(TIMING_FFLUSH, start);
+    return res;
+}
+
+int timed_fclose(FILE *stream)
+{
+    uint32_t start = us_ticker_read();
+    int res = fclose(stream);
+    record(TIMING_FCLOSE, start);
+    return res;
+}
+
+void posix_timing_case_start()
+{
+    for (int op = 0; op < TIMING_OPS; op++) {
+        case_hist[op].reset();
+        case_bytes[op] = 0;
+    }
+}
+
+const LatencyHistogram &posix_timing_case(posix_timing_op_t op)
+{
+    return case_hist[op];
+}
+
+const LatencyHistogram &posix_timing_total(posix_timing_op_t op)
+{
+    return total_hist[op];
+}
+
+uint64_t posix_timing_case_bytes(posix_timing_op_t op)
+{
+    return case_bytes[op];
+}
+
+const char *posix_timing_name(posix_timing_op_t op)
+{
+    return op_names[op];
+}
+
+static void print(const char *title, const LatencyHistogram *hist)
+{
+    printf("%-14s %8s %8s %8s %8s %8s\n", title, "count", "p50", "p90", "p99", "max");
+    for (int op = 0; op < TIMING_OPS; op++) {
+        if (!hist[op].count()) {
+            continue;
+        }
+
+        printf("%-14s %8lu %8lu %8lu %8lu %8lu\n", op_names[op],
+               (unsigned long)hist[op].count(),
+               (unsigned long)hist[op].percentile(50),
+               (unsigned long)hist[op].percentile(90),
+               (unsigned long)hist[op].percentile(99),
+               (unsigned long)hist[op].max());
+    }
+}
+
+void posix_timing_print_case()
+{
+    print("case (us)", case_hist);
+}
+
+void posix_timing_print_total()
+{
+    print("total (us)", total_hist);
+}
+
+void posix_timing_report_case()
+{
+    for (int op = 0; op < TIMING_OPS; op++) {
+        if (!case_hist[op].count()) {
+            continue;
+        }
+
+        perf_report(case_hist[op].count(), "%s_count", op_names[op]);
+        perf_report(case_hist[op].percentile(50), "%s_p50_us", op_names[op]);
+        perf_report(case_hist[op].percentile(90), "%s_p90_us", op_names[op]);
+        perf_report(case_hist[op].percentile(99), "%s_p99_us", op_names[op]);
+        perf_report(case_hist[op].max(), "%s_max_us", op_names[op]);
+    }
+}
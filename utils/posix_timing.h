@@ -0,0 +1,69 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef POSIX_TIMING_H
+#define POSIX_TIMING_H
+
+#include <stdio.h>
+#include "LatencyHistogram.h"
+
+/* Timed versions of the stdio calls under test. Every call is recorded in
+ * the histogram of its operation for the current test case, and in the
+ * histogram of the whole run. The bytes moved by fwrite and fread are
+ * counted as well. A test routes its calls through them with
+ * object-like macros, e.g. "#define fopen timed_fopen".
+ */
+enum posix_timing_op_t {
+    TIMING_FOPEN,
+    TIMING_FWRITE,
+    TIMING_FREAD,
+    TIMING_FSEEK,
+    TIMING_FFLUSH,
+    TIMING_FCLOSE,
+    TIMING_OPS
+};
+
+FILE *timed_fopen(const char *path, const char *mode);
+size_t timed_fwrite(const void *ptr, size_t size, size_t nmemb, FILE *stream);
+size_t timed_fread(void *ptr, size_t size, size_t nmemb, FILE *stream);
+int timed_fseek(FILE *stream, long offset, int whence);
+int timed_fflush(FILE *stream);
+int timed_fclose(FILE *stream);
+
+// Clear the histograms of the current test case
+void posix_timing_case_start();
+
+// Histogram of an operation for the current test case
+const LatencyHistogram &posix_timing_case(posix_timing_op_t op);
+
+// Histogram of an operation for the whole run
+const LatencyHistogram &posix_timing_total(posix_timing_op_t op);
+
+// Bytes transferred by fwrite or fread in the current test case
+uint64_t posix_timing_case_bytes(posix_timing_op_t op);
+
+// Name of an operation
+const char *posix_timing_name(posix_timing_op_t op);
+
+// Print p50/p90/p99/max of every operation called in the current test case
+void posix_timing_print_case();
+
+// Print p50/p90/p99/max of every operation called during the run
+void posix_timing_print_total();
+
+// Send count/p50/p90/p99/max of every operation called in the current test case to the host
+void posix_timing_report_case();
+
+#endif
@@ -0,0 +1,224 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "test_storage.h"
+#include <string.h>
+
+#ifdef TEST_SPIF
+#include "SPIFBlockDevice.h"
+#elif defined TEST_SD
+#include "SDBlockDevice.h"
+#elif defined TEST_HEAP
+#include "HeapBlockDevice.h"
+#elif defined TEST_SIM_NOR || defined TEST_SIM_SD
+#include "SimFlashBlockDevice.h"
+#endif
+
+#ifdef TEST_SPIF
+static SPIFBlockDevice test_bd(
+    MBED_CONF_SPIF_DRIVER_SPI_MOSI,
+    MBED_CONF_SPIF_DRIVER_SPI_MISO,
+    MBED_CONF_SPIF_DRIVER_SPI_CLK,
+    MBED_CONF_SPIF_DRIVER_SPI_CS
+    );
+#elif defined TEST_SD
+static SDBlockDevice test_bd(
+    MBED_CONF_SD_SPI_MOSI,
+    MBED_CONF_SD_SPI_MISO,
+    MBED_CONF_SD_SPI_CLK,
+    MBED_CONF_SD_SPI_CS
+    );
+#elif defined TEST_HEAP
+#ifndef BLOCK_SIZE
+#define BLOCK_SIZE 512
+#endif
+#ifndef BLOCK_COUNT
+#define BLOCK_COUNT 512
+#endif
+static HeapBlockDevice test_bd(
+    BLOCK_COUNT*BLOCK_SIZE,
+    BLOCK_SIZE
+    );
+#elif defined TEST_SIM_NOR
+// Geometry and typical timing of the SPI NOR flash on the SPIF boards
+#ifndef SIM_READ_SIZE
+#define SIM_READ_SIZE 1
+#endif
+#ifndef SIM_PROGRAM_SIZE
+#define SIM_PROGRAM_SIZE 1
+#endif
+#ifndef SIM_ERASE_SIZE
+#define SIM_ERASE_SIZE 4096
+#endif
+#ifndef SIM_PAGE_SIZE
+#define SIM_PAGE_SIZE 256
+#endif
+#ifndef SIM_BLOCK_COUNT
+#define SIM_BLOCK_COUNT 32
+#endif
+#ifndef SIM_READ_US
+#define SIM_READ_US 20
+#endif
+#ifndef SIM_READ_NS_PER_BYTE
+#define SIM_READ_NS_PER_BYTE 1000
+#endif
+#ifndef SIM_PROGRAM_US
+#define SIM_PROGRAM_US 850
+#endif
+#ifndef SIM_PROGRAM_NS_PER_BYTE
+#define SIM_PROGRAM_NS_PER_BYTE 1000
+#endif
+#ifndef SIM_ERASE_US
+#define SIM_ERASE_US 40000
+#endif
+#ifndef SIM_ERASE_VALUE
+#define SIM_ERASE_VALUE 0xff
+#endif
+#elif defined TEST_SIM_SD
+// Geometry and typical timing of an SD card in SPI mode
+#ifndef SIM_READ_SIZE
+#define SIM_READ_SIZE 512
+#endif
+#ifndef SIM_PROGRAM_SIZE
+#define SIM_PROGRAM_SIZE 512
+#endif
+#ifndef SIM_ERASE_SIZE
+#define SIM_ERASE_SIZE 512
+#endif
+#ifndef SIM_PAGE_SIZE
+#define SIM_PAGE_SIZE 512
+#endif
+#ifndef SIM_BLOCK_COUNT
+#define SIM_BLOCK_COUNT 256
+#endif
+#ifndef SIM_READ_US
+#define SIM_READ_US 300
+#endif
+#ifndef SIM_READ_NS_PER_BYTE
+#define SIM_READ_NS_PER_BYTE 1000
+#endif
+#ifndef SIM_PROGRAM_US
+#define SIM_PROGRAM_US 1000
+#endif
+#ifndef SIM_PROGRAM_NS_PER_BYTE
+#define SIM_PROGRAM_NS_PER_BYTE 1000
+#endif
+#ifndef SIM_ERASE_US
+#define SIM_ERASE_US 0
+#endif
+#ifndef SIM_ERASE_VALUE
+#define SIM_ERASE_VALUE -1
+#endif
+#endif
+
+#if defined TEST_SIM_NOR || defined TEST_SIM_SD
+static const sim_flash_timing_t sim_timing = {
+    SIM_READ_US,
+    SIM_READ_NS_PER_BYTE,
+    SIM_PROGRAM_US,
+    SIM_PROGRAM_NS_PER_BYTE,
+    SIM_ERASE_US
+};
+static SimFlashBlockDevice test_bd(
+    SIM_BLOCK_COUNT*SIM_ERASE_SIZE,
+    SIM_READ_SIZE,
+    SIM_PROGRAM_SIZE,
+    SIM_ERASE_SIZE,
+    SIM_PAGE_SIZE,
+    sim_timing,
+    SIM_ERASE_VALUE
+    );
+#endif
+
+BlockDevice &bd = test_bd;
+
+static FATFileSystem fat_fs("fat");
+static LittleFileSystem little_fs("lfs");
+
+#ifdef TEST_LFS
+static test_fs_t fs_type = TEST_FS_LFS;
+FileSystem *fs = &little_fs;
+#else
+static test_fs_t fs_type = TEST_FS_FAT;
+FileSystem *fs = &fat_fs;
+#endif
+
+const char *test_bd_name()
+{
+#ifdef TEST_SPIF
+    return "spif";
+#elif defined TEST_SD
+    return "sd";
+#elif defined TEST_SIM_NOR
+    return "sim_nor";
+#elif defined TEST_SIM_SD
+    return "sim_sd";
+#else
+    return "heap";
+#endif
+}
+
+int test_bd_allocate()
+{
+#if defined TEST_HEAP || defined TEST_SIM_NOR || defined TEST_SIM_SD
+    int res = bd.init();
+    if (res) {
+        return res;
+    }
+
+    // Programming erased bytes leaves the device as it was, erased or zeroed
+    bd_size_t erase_size = bd.get_erase_size();
+    uint8_t *buf = new uint8_t[erase_size];
+    memset(buf, bd.get_erase_value() < 0 ? 0 : bd.get_erase_value(), erase_size);
+
+    for (bd_addr_t addr = 0; addr < bd.size() && !res; addr += erase_size) {
+        res = bd.program(buf, addr, erase_size);
+    }
+
+    delete[] buf;
+    bd.deinit();
+    return res;
+#else
+    return 0;
+#endif
+}
+
+void test_fs_select(test_fs_t type)
+{
+    fs_type = type;
+    if (type == TEST_FS_LFS) {
+        fs = &little_fs;
+    } else {
+        fs = &fat_fs;
+    }
+}
+
+test_fs_t test_fs_type()
+{
+    return fs_type;
+}
+
+const char *test_fs_name()
+{
+    return fs_type == TEST_FS_LFS ? "lfs" : "fat";
+}
+
+int test_fs_format(BlockDevice *bd)
+{
+    if (fs_type == TEST_FS_LFS) {
+        return LittleFileSystem::format(bd);
+    }
+    return FATFileSystem::format(bd);
+}
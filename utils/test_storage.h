@@ -0,0 +1,75 @@
+/* Copyright (c) 2017 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TEST_STORAGE_H
+#define TEST_STORAGE_H
+
+#include "BlockDevice.h"
+#include "LittleFileSystem.h"
+#include "FATFileSystem.h"
+
+/* The block device is selected at compile time with -DTEST_SPIF (default),
+ * -DTEST_SD, -DTEST_HEAP or the simulated flash parts -DTEST_SIM_NOR and
+ * -DTEST_SIM_SD. Both file systems are available at run time,
+ * -DTEST_FAT (default) or -DTEST_LFS selects the one used until
+ * test_fs_select() is called.
+ */
+#if !defined(TEST_SD) && !defined(TEST_HEAP) && !defined(TEST_SIM_NOR) && !defined(TEST_SIM_SD)
+#define TEST_SPIF
+#endif
+
+#if !defined(TEST_SPIF) && !defined(TEST_SD) && !defined(TEST_HEAP) && !defined(TEST_SIM_NOR) && !defined(TEST_SIM_SD)
+#error [NOT_SUPPORTED] storage test not supported on this platform
+#endif
+
+#if !defined(TEST_LFS) && !defined(TEST_FAT)
+#define TEST_FAT
+#endif
+
+enum test_fs_t {
+    TEST_FS_FAT,
+    TEST_FS_LFS,
+    TEST_FS_COUNT
+};
+
+extern BlockDevice &bd;
+
+/* Name of the block device selected at compile time, "spif", "sd", "heap",
+ * "sim_nor" or "sim_sd"
+ */
+const char *test_bd_name();
+
+/* Allocate all the storage of a RAM backed block device, TEST_HEAP and the
+ * simulated parts allocate it on the first program of every block otherwise.
+ * Nothing to do on SPIF and SD.
+ */
+int test_bd_allocate();
+
+// Selected file system, mounted as "/fat" or "/lfs"
+extern FileSystem *fs;
+
+// Select the file system fs points to, the previous one must be unmounted
+void test_fs_select(test_fs_t type);
+
+// Type of the selected file system
+test_fs_t test_fs_type();
+
+// Mount name of the selected file system, "fat" or "lfs"
+const char *test_fs_name();
+
+// Format a block device with the selected file system
+int test_fs_format(BlockDevice *bd);
+
+#endif